@@ -1,21 +1,51 @@
-#version 330
+#version 430
 
 layout (location = 0) in vec3 vertPosCoords;
-layout (location = 1) in vec4 vertRgbaColor;
-layout (location = 2) in int biomeIndex;
-layout (location = 3) in int plateIndex;
-layout (location = 4) in float temperature;
-layout (location = 5) in float rainfall;
-layout (location = 6) in int populationIndex;
-layout (location = 7) in int languageIndex;
+layout (location = 1) in uint vertHex;
+
+struct HexAttributes
+{
+    int biome;
+    int biomeVariation;
+    int tectonicPlate;
+    int river;
+    float temperature;
+    float rainfall;
+    int population;
+    int language;
+};
+
+layout (std430, binding = 0) readonly buffer HexBuffer
+{
+    HexAttributes hexes[];
+};
+
+const uint SideFlag = 0x80000000u;
 
 out vec4 rgbaColor;
 
-uniform vec4 BiomeColors[64];
-uniform vec4 PlateColors[64];
+/*
+    Each focus gets its own copy of this shader, with FOCUS
+    defined as the focus's number, so only the coloring
+    for that focus is ever compiled in.
+*/
+#ifndef FOCUS
+#define FOCUS 0
+#endif
+
+layout (std140, binding = 0) uniform Palettes
+{
+    vec4 BiomeColors[64];
+    vec4 PlateColors[64];
+};
+
+// One color per population (or language), by id.
+layout (std430, binding = 1) readonly buffer IdentityPalette
+{
+    vec4 IdentityColors[];
+};
 
 uniform mat4 MVP;
-uniform int Focus;
 
 const vec4 lowestRain = vec4(1.0, 0.0, 0.0, 1.0);
 const vec4 midRain = vec4(0.0, 0.0, 1.0, 1.0);
@@ -25,55 +55,55 @@ const vec4 lowestTemp = vec4(0.9, 1.0, 1.0, 1.0);
 const vec4 midTemp = vec4(0.0, 1.0, 0.0, 1.0);
 const vec4 highestTemp = vec4(1.0, 0.0, 0.0, 1.0);
 
-float rand(float n){return fract(sin(n) * 43758.5453123);}
+vec4 primaryColor(bool side, HexAttributes hex)
+{
+    if (side && hex.river != 0) return vec4(0.0, 0.0, 1.0, 1.0);
+    else if (side) return vec4(0.5, 0.5, 0.5, 1.0);
+    return vec4(1.0, 1.0, 1.0, 1.0);
+}
 
-float noise(float p){
-	float fl = floor(p);
-  float fc = fract(p);
-	return mix(rand(fl), rand(fl + 1.0), fc);
+vec4 identityColor(int id)
+{
+    return IdentityColors[uint(id) % uint(IdentityColors.length())];
 }
 
 void main()
 {
-    if (Focus == 0) rgbaColor = vertRgbaColor;
-    else if (biomeIndex == 0 || Focus == 1) rgbaColor = BiomeColors[biomeIndex];
-    else if (Focus == 2) rgbaColor = PlateColors[plateIndex];
-    else if (Focus == 3)
-    {
-        vec4 midA = mix(lowestTemp, midTemp, temperature);
-        vec4 midB = mix(midTemp, highestTemp, temperature);
-        rgbaColor = mix(midA, midB, temperature);
-    }
-    else if (Focus == 4)
-    {
-        vec4 midA = mix(lowestRain, midRain, rainfall);
-        vec4 midB = mix(midRain, highestRain, rainfall);
-        rgbaColor = mix(midA, midB, rainfall);
-    }
-    else if (Focus == 5 && populationIndex > 0)
-    {
-        float r = mod(rand(populationIndex), 1.0);
-        float g = mod(rand(populationIndex + 1), 1.0);
-        float b = mod(rand(populationIndex + 2), 1.0);
-        
-        rgbaColor = vec4(r, g, b, 1.0);
-    }
-    else if (Focus == 5)
-    {
-        rgbaColor = vertRgbaColor;
-    }
-    else if (Focus == 6 && languageIndex > 0)
-    {
-        float r = mod(rand(languageIndex), 1.0);
-        float g = mod(rand(languageIndex + 1), 1.0);
-        float b = mod(rand(languageIndex + 2), 1.0);
+    bool side = (vertHex & SideFlag) != 0u;
+    HexAttributes hex = hexes[vertHex & ~SideFlag];
 
-        rgbaColor = vec4(r, g, b, 1.0);
-    }
-    else if (Focus == 6)
+#if FOCUS == 0
+    rgbaColor = primaryColor(side, hex);
+#else
+    int biomeIndex = hex.biome;
+    if (!side) biomeIndex += hex.biomeVariation;
+
+    // The ocean is always drawn in its biome color.
+    rgbaColor = BiomeColors[biomeIndex];
+
+#if FOCUS != 1
+    if (biomeIndex != 0)
     {
-        rgbaColor = vertRgbaColor;
+#if FOCUS == 2
+        rgbaColor = PlateColors[hex.tectonicPlate];
+#elif FOCUS == 3
+        vec4 midA = mix(lowestTemp, midTemp, hex.temperature);
+        vec4 midB = mix(midTemp, highestTemp, hex.temperature);
+        rgbaColor = mix(midA, midB, hex.temperature);
+#elif FOCUS == 4
+        vec4 midA = mix(lowestRain, midRain, hex.rainfall);
+        vec4 midB = mix(midRain, highestRain, hex.rainfall);
+        rgbaColor = mix(midA, midB, hex.rainfall);
+#elif FOCUS == 5
+        if (hex.population > 0) rgbaColor = identityColor(hex.population);
+        else rgbaColor = primaryColor(side, hex);
+#elif FOCUS == 6
+        if (hex.language > 0) rgbaColor = identityColor(hex.language);
+        else rgbaColor = primaryColor(side, hex);
+#endif
     }
-    
+#endif
+#endif
+
     gl_Position = MVP * vec4(vertPosCoords, 1.0);
 }
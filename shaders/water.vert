@@ -1,65 +1,42 @@
-#version 330
+#version 430
 
-layout (location = 0) in vec3 vertPosCoords;
-layout (location = 1) in vec4 vertRgbaColor;
+layout (location = 0) in vec3 vertPatchCoords;
+layout (location = 1) in vec3 cornerA;
+layout (location = 2) in vec3 cornerB;
+layout (location = 3) in vec3 cornerC;
 
 out vec4 rgbaColor;
 
 uniform mat4 MVP;
-uniform float time1;
-uniform float time2;
+uniform vec3 Center;
+uniform float Radius;
+uniform float WaveHeight;
+uniform float SkirtDepth;
+uniform float Time;
+uniform vec4 Color;
 
-float rand(vec2 c){
-	return fract(sin(dot(c.xy ,vec2(12.9898,78.233))) * 43758.5453);
-}
+layout (binding = 0) uniform sampler2D Noise;
 
-const float PI = 3.14159265358979323846;
-const float spread = 1000;
+const float scale = 1.5;
+const vec2 drift = vec2(0.004, 0.003);
 
-float noise(vec2 p, float freq ){
-	float unit = spread/freq;
-	vec2 ij = floor(p/unit);
-	vec2 xy = mod(p,unit)/unit;
-	//xy = 3.*xy*xy-2.*xy*xy*xy;
-	xy = .5*(1.-cos(PI*xy));
-	float a = rand((ij+vec2(0.,0.)));
-	float b = rand((ij+vec2(1.,0.)));
-	float c = rand((ij+vec2(0.,1.)));
-	float d = rand((ij+vec2(1.,1.)));
-	float x1 = mix(a, b, xy.x);
-	float x2 = mix(c, d, xy.x);
-	return mix(x1, x2, xy.y);
-}
+void main()
+{
+	rgbaColor = Color;
 
-float pNoise(vec2 p, int res){
-	float persistance = .5;
-	float n = 0.;
-	float normK = 0.;
-	float f = 4.;
-	float amp = 1.;
-	int iCount = 0;
-	for (int i = 0; i<50; i++){
-		n+=amp*noise(p, f);
-		f*=2.;
-		normK+=amp;
-		amp*=persistance;
-		if (iCount == res) break;
-		iCount++;
-	}
-	float nf = n/normK;
-	return nf*nf*nf*nf;
-}
+	// The patch coordinates say how far toward the second and
+	// third corners we are; the skirt hangs straight down.
+	float u = vertPatchCoords.x;
+	float v = vertPatchCoords.y;
+	float skirt = vertPatchCoords.z;
 
-const float delta = 0.0001;
+	vec3 direction = normalize(cornerA * (1.0 - u - v) + cornerB * u + cornerC * v);
 
-void main()
-{
-    rgbaColor = vertRgbaColor;
+	// Two copies of the noise drifting past each other, so
+	// the waves change shape rather than just sliding along.
+	float wave = 0.5 * (texture(Noise, direction.xy * scale + drift * Time).r + texture(Noise, direction.yz * scale - drift * Time).r);
 
-    float pastOutput = noise(vertPosCoords.xy, time1);
-    float nextOutput = noise(vertPosCoords.xy, time2);
-    float mag = mix(pastOutput, nextOutput, delta);
-    vec3 add = mag * normalize(vertPosCoords);
+	float height = Radius + wave * WaveHeight - skirt * SkirtDepth;
 
-    gl_Position = MVP * vec4(vertPosCoords + add, 1.0);
+	gl_Position = MVP * vec4(Center + direction * height, 1.0);
 }
@@ -4,6 +4,7 @@
 	The unmoved mover....
 */
 
+#include <time.h>
 #include <chrono>
 #include <string>
 #include <sstream>
@@ -12,11 +13,48 @@
 
 #include "world/chunk.h"
 #include "util/geometry.h"
+#include "simulation/history.h"
 #include "rendering/renderer.h"
 
 #define VERSION 0.01
 
-void main()
+/*
+	Headless mode runs the planet and its history without
+	ever creating a window or an OpenGL context, so that
+	we can simulate as fast as the CPU allows.
+*/
+int RunHeadless(unsigned int years, Mandalin::WorldSeed seed)
+{
+	Mandalin::Settings::Setup(seed);
+
+	Mandalin::Planet* planet = new Mandalin::Planet(Mandalin::Settings::WorldSize, seed);
+	Mandalin::History* history = new Mandalin::History(planet);
+
+	auto start = std::chrono::steady_clock::now();
+	unsigned int lastYear = history->GetYear();
+	unsigned int finalYear = lastYear + years;
+
+	while (history->GetYear() < finalYear)
+	{
+		history->Update();
+
+		if (history->GetYear() != lastYear)
+		{
+			lastYear = history->GetYear();
+			std::cout << "Reached year " << lastYear << "." << std::endl;
+		}
+	}
+
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	std::cout << "Simulated " << years << " years in " << elapsed.count() << " seconds." << std::endl;
+
+	delete history;
+	delete planet;
+
+	return 0;
+}
+
+int main(int argc, char* argv[])
 {
 	/*
 		Let's get some meta-details straight.
@@ -26,6 +64,32 @@ void main()
 	o << std::setprecision(2) << std::noshowpoint << VERSION;
 	std::cout << "Running Mandalin, version: " + o.str() + "." << std::endl;
 
+	/*
+		Next, we see how we've been asked to run.
+	*/
+	bool headless = false;
+	unsigned int years = Mandalin::Settings::HeadlessYears;
+	uint64_t seedValue = time(NULL);
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+
+		if (arg == "--headless") headless = true;
+		else if (arg == "--years" && i + 1 < argc) years = std::stoul(argv[++i]);
+		else if (arg == "--seed" && i + 1 < argc) seedValue = std::stoull(argv[++i]);
+	}
+
+	/*
+		Everything random about the world comes out of this
+		seed, so we print it out in case we want to get back
+		to a world we liked (or one that broke something).
+	*/
+	Mandalin::WorldSeed seed(seedValue);
+	std::cout << "World seed: " << seed.Value() << "." << std::endl;
+
+	if (headless) return RunHeadless(years, seed);
+
 	/*
 		Now we go through the process of initializing OpenGL,
 		GLAD, GLFW, GLADOS, GLERP, GLEW, whatever....
@@ -39,7 +103,7 @@ void main()
 	if (!glfwInit())
 	{
 		std::cout << "Failed to initialize GLFW." << std::endl;
-		return;
+		return -1;
 	}
 
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
@@ -55,7 +119,7 @@ void main()
 	{
 		glfwTerminate();
 		std::cout << "Failed to create Opengl Window." << std::endl;
-		return;
+		return -1;
 	}
 
 	glfwMakeContextCurrent(window);
@@ -63,7 +127,7 @@ void main()
 	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
 	{
 		std::cout << "Failed to initialize GLAD" << std::endl;
-		return;
+		return -1;
 	}
 
 	glEnable(GL_BLEND);
@@ -78,11 +142,13 @@ void main()
 		Now we're going to fire up rendering:
 		camera, renderer, etc.
 	*/
-	Mandalin::Settings::Setup();
+	Mandalin::Settings::Setup(seed);
 	Mandalin::Camera* camera = new Mandalin::Camera({ 0, 1, 113.144f }, { 1, 0, 0, 0 }, 1.0f, window);
 	Mandalin::Renderer* renderer = new Mandalin::Renderer(camera);
 
-	Mandalin::Planet* planet = new Mandalin::Planet(Mandalin::Settings::WorldSize);
+	Mandalin::Planet* planet = new Mandalin::Planet(Mandalin::Settings::WorldSize, seed);
+	planet->LoadGeometry();
+
 	Mandalin::History* history = new Mandalin::History(planet);
 
 	/*
@@ -133,7 +199,10 @@ void main()
 
 	std::cout << "Shutting down Mandalin. Have a wonderful day!" << std::endl;
 
+	delete history;
 	delete planet;
 	delete renderer;
 	delete camera;
+
+	return 0;
 }
\ No newline at end of file
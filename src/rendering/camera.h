@@ -109,6 +109,7 @@ namespace Mandalin
 		
 		void				SetLens(Lens l) { lens = l; }
 
+		glm::mat4			GetProjection() { return projection; }
 		glm::mat4			GetViewProjection() { return projection * view; }
 
 		void				UpdateView();
@@ -1,95 +1,174 @@
 #include "renderer.h"
 #include <iostream>
+#include <algorithm>
 
 namespace Mandalin
 {
+	/*-----------------------------------------------*/
+	/* Palettes */
+	/*-----------------------------------------------*/
+	void Renderer::UpdatePalettes()
+	{
+		if (paletteVersion == Settings::PaletteVersion) return;
+
+		glBindBuffer(GL_UNIFORM_BUFFER, paletteBuffer);
+		glBufferSubData(GL_UNIFORM_BUFFER, 0, 64 * sizeof(glm::vec4), &Settings::BiomeColors[0]);
+		glBufferSubData(GL_UNIFORM_BUFFER, 64 * sizeof(glm::vec4), 64 * sizeof(glm::vec4), &Settings::TectonicPlateColors[0]);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, identityBuffer);
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, Settings::IdentityColorCount * sizeof(glm::vec4), &Settings::IdentityColors[0]);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+		paletteVersion = Settings::PaletteVersion;
+	}
+
 	/*-----------------------------------------------*/
 	/* Render */
 	/*-----------------------------------------------*/
 	void Renderer::Render(Planet* planet)
 	{
-		shaders[1].Use();
-		shaders[1].SetMatrix("MVP", camera->GetViewProjection());
-		shaders[1].SetInt("Focus", (int)camera->GetFocus());
-		shaders[1].SetVector4Arr("BiomeColors", Settings::BiomeColors[0], 64);
-		shaders[1].SetVector4Arr("PlateColors", Settings::TectonicPlateColors[0], 64);
+		planet->FlushChunks();
+
+		/*
+			Every land shader is checked on each frame, so that
+			each one is saved to the cache as soon as it's built,
+			whether or not its focus is ever chosen. A newly
+			chosen focus's shader might still be being built, in
+			which case we stay on the last one until it's ready
+			rather than stall waiting for it.
+		*/
+		for (int i = 0; i < landShaders.size(); i++) landShaders[i].Ready();
+
+		unsigned int focus = (unsigned int)camera->GetFocus();
+		if (focus != landFocus && landShaders[focus].Ready()) landFocus = focus;
+
+		Shader* landShader = &landShaders[landFocus];
+		landShader->Use();
+		landShader->SetMatrix("MVP", camera->GetViewProjection());
+
+		UpdatePalettes();
+
+		glBindBufferBase(GL_UNIFORM_BUFFER, 0, paletteBuffer);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, planet->GetHexBuffer());
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, identityBuffer);
 
 		Ocean* ocean = planet->GetOcean();
 
-		glm::vec3 camPos = -camera->GetPosition();
+		/*
+			Only the chunks which might actually be seen are
+			drawn: those inside the camera's frustum, not facing
+			entirely away from it, and not over the horizon.
+		*/
+		Frustum frustum(camera->GetViewProjection());
+		bool eye = camera->GetLens() == Lens::perspective;
+		glm::vec3 camPos = camera->GetPosition();
 		glm::vec3 planetPos = planet->GetPosition();
 
-		float camDistance = glm::distance(camPos, planetPos);
-		float relCamDistance = glm::distance(camPos, planetPos) / planet->GetRadius();
-		float highestTheta = 1.74f * relCamDistance;
+		/*
+			Every chunk lives in the same buffers, so rather than
+			drawing them one at a time we write a command for each
+			one we want and hand the lot over in a single call.
+		*/
+		commands.clear();
+		visible.clear();
 
-		glm::vec3 ab = planetPos - camPos;
+		planet->GetChunkBounds().Cull(frustum, eye, camPos, planetPos, planet->GetOccluderRadius(), visible);
 
-		float time1 = lastTime;
-		float time2 = Lerp(lastTime, (rand() % 1000), 0.0001f);
+		/*
+			Each chunk that's left is drawn from its full or its
+			coarse mesh depending on how many pixels across its
+			hexes come out on screen. Up close, that's the hex
+			size over the distance to the nearest edge of the
+			chunk's bounds, scaled by the projection; with the
+			orthographic lens, distance doesn't come into it.
+		*/
+		if (coarse.size() != planet->ChunkCount()) coarse.assign(planet->ChunkCount(), false);
 
-		if (planet->GetWorldSize() < 8)
-		{
-			/*
-				On sufficiently small worlds, the cost of just rendering
-				all the tiles is not that great, so we can just throw
-				all the chunks into the renderer. At some point, we may
-				re-implement a better culling method.
-			*/
-
-			for (int i = 0; i < planet->ChunkCount(); i++)
-			{
-				Chunk* c = planet->GetChunk(i);
-				glBindVertexArray(c->vao);
-				glBindBuffer(GL_ARRAY_BUFFER, c->vbo);
-				glDrawElements(GL_TRIANGLES, c->triCount * 3, GL_UNSIGNED_INT, nullptr);
-			}
-		}
-		else
+		float pixelsPerUnit = fabsf(camera->GetProjection()[1][1]) * (camera->GetWindowHeight() / 2.0f);
+		float hexPixels = planet->GetHexSize() * pixelsPerUnit;
+
+		for (int i = 0; i < visible.size(); i++)
 		{
-			for (int i = 0; i < planet->ChunkCount(); i++)
-			{
-				/*
-					On larger worlds, we really can't afford to
-					render all the tiles.
-				*/
-				Chunk* c = planet->GetChunk(i);
-
-				glm::vec3 bc = c->center - planetPos;
-
-				float dotABC = glm::dot(ab, bc);
-				float magABC = glm::length(ab) * glm::length(bc);
-
-				float theta = acosf(dotABC / magABC);
-
-				if (theta < highestTheta || isnan(theta))
-				{
-					glBindVertexArray(c->vao);
-					glBindBuffer(GL_ARRAY_BUFFER, c->vbo);
-					glDrawElements(GL_TRIANGLES, c->triCount * 3, GL_UNSIGNED_INT, nullptr);
-				}
-			}
+			Chunk* c = planet->GetChunk(visible[i]);
+
+			float pixels = hexPixels;
+			if (eye) pixels /= std::max(glm::distance(camPos, c->bounds.center) - c->bounds.radius, Settings::NearClip);
+
+			if (coarse[c->index] && pixels > Settings::LodHexPixels * Settings::LodHysteresis) coarse[c->index] = false;
+			else if (!coarse[c->index] && pixels < Settings::LodHexPixels) coarse[c->index] = true;
+
+			commands.push_back(coarse[c->index] ? c->coarse.Command() : c->full.Command());
 		}
 
+		glBindVertexArray(planet->GetVAO());
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+		glBufferData(GL_DRAW_INDIRECT_BUFFER, commands.size() * sizeof(DrawCommand), commands.data(), GL_STREAM_DRAW);
+		glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_SHORT, nullptr, commands.size(), 0);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
 		/*
-			Regardless of the world-size, we just render all the
-			oceans. The cost is fairly marginal regardless.
+			The ocean's patches are culled the same way, and each
+			one is drawn from whichever of the ocean's meshes
+			keeps its cells about Settings::OceanCellPixels
+			across. The patches are sorted by mesh into their
+			instances, and each mesh is then one command.
 		*/
+		visible.clear();
+		ocean->GetPatchBounds().Cull(frustum, eye, camPos, planetPos, planet->GetOccluderRadius(), visible);
 
-		shaders[0].Use();
-		shaders[0].SetMatrix("MVP", camera->GetViewProjection());
-		shaders[0].SetFloat("time1", time1);
-		shaders[0].SetFloat("time2", time2);
+		oceanLevels.resize(ocean->MeshCount());
+		for (int i = 0; i < oceanLevels.size(); i++) oceanLevels[i].clear();
 
-		for (int i = 0; i < ocean->ChunkCount(); i++)
+		float patchPixels = ocean->GetPatchSize() * pixelsPerUnit;
+
+		for (int i = 0; i < visible.size(); i++)
 		{
-			OceanChunk* c = ocean->GetChunk(i);
-			glBindVertexArray(c->vao);
-			glBindBuffer(GL_ARRAY_BUFFER, c->vbo);
-			glDrawElements(GL_TRIANGLES, c->triCount * 3, GL_UNSIGNED_INT, nullptr);
+			OceanPatch* p = ocean->GetPatch(visible[i]);
+
+			float pixels = patchPixels;
+			if (eye) pixels /= std::max(glm::distance(camPos, p->bounds.center) - p->bounds.radius, Settings::NearClip);
+
+			unsigned int level = 0;
+			while (level + 1 < ocean->MeshCount() && (1u << level) * Settings::OceanCellPixels < pixels) level++;
+
+			oceanLevels[level].push_back({ p->a.x, p->a.y, p->a.z, p->b.x, p->b.y, p->b.z, p->c.x, p->c.y, p->c.z });
+		}
+
+		commands.clear();
+		oceanInstances.clear();
+
+		for (unsigned int level = 0; level < oceanLevels.size(); level++)
+		{
+			if (oceanLevels[level].empty()) continue;
+
+			ChunkMesh* mesh = ocean->GetMesh(level);
+			commands.push_back({ mesh->indexCount, (unsigned int)oceanLevels[level].size(), mesh->indexStart, (int)mesh->vertexStart, (unsigned int)oceanInstances.size() });
+			oceanInstances.insert(oceanInstances.end(), oceanLevels[level].begin(), oceanLevels[level].end());
 		}
 
-		lastTime = time2;
+		shaders[0].Use();
+		shaders[0].SetMatrix("MVP", camera->GetViewProjection());
+		shaders[0].SetVector3("Center", planetPos);
+		shaders[0].SetFloat("Radius", ocean->GetRadius());
+		shaders[0].SetFloat("WaveHeight", Settings::OceanWaveHeight);
+		shaders[0].SetFloat("SkirtDepth", Settings::OceanSkirtDepth);
+		shaders[0].SetFloat("Time", (float)glfwGetTime());
+		shaders[0].SetVector4("Color", Settings::OceanColor);
+
+		glBindVertexArray(ocean->GetVAO());
+		glBindBuffer(GL_ARRAY_BUFFER, ocean->GetInstanceBuffer());
+		glBufferData(GL_ARRAY_BUFFER, oceanInstances.size() * sizeof(OceanInstance), oceanInstances.data(), GL_STREAM_DRAW);
+
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, ocean->GetNoiseTexture());
+
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+		glBufferData(GL_DRAW_INDIRECT_BUFFER, commands.size() * sizeof(DrawCommand), commands.data(), GL_STREAM_DRAW);
+		glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_SHORT, nullptr, commands.size(), 0);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+		glBindTexture(GL_TEXTURE_2D, 0);
 
 		glBindVertexArray(0);
 		glBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -106,12 +185,34 @@ namespace Mandalin
 		Shader waterShader = { "assets/shaders/water.vert", "assets/shaders/water.frag" };
 		shaders.push_back(waterShader);
 
-		Shader baseShader = { "assets/shaders/base.vert", "assets/shaders/base.frag" };
-		shaders.push_back(baseShader);
+		/*
+			The land gets one build of the base shader for each
+			focus, so switching focus is just a matter of which
+			one we use.
+		*/
+		for (unsigned int i = 0; i < FocusCount; i++)
+		{
+			std::string defines = "#define FOCUS " + std::to_string(i) + "\n";
+			landShaders.push_back(Shader("assets/shaders/base.vert", "assets/shaders/base.frag", defines));
+		}
+
+		glGenBuffers(1, &indirectBuffer);
+
+		glGenBuffers(1, &paletteBuffer);
+		glBindBuffer(GL_UNIFORM_BUFFER, paletteBuffer);
+		glBufferData(GL_UNIFORM_BUFFER, 2 * 64 * sizeof(glm::vec4), nullptr, GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+		glGenBuffers(1, &identityBuffer);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, identityBuffer);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, Settings::IdentityColorCount * sizeof(glm::vec4), nullptr, GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
 	}
 
 	Renderer::~Renderer()
 	{
-		// Nothing quite yet.
+		glDeleteBuffers(1, &indirectBuffer);
+		glDeleteBuffers(1, &paletteBuffer);
+		glDeleteBuffers(1, &identityBuffer);
 	}
 }
\ No newline at end of file
@@ -39,7 +39,50 @@ namespace Mandalin
 		/* Shaders */
 		/*-----------------------------------------------*/
 		std::vector<Shader>		shaders;
-		float					lastTime = 0.0f;
+
+		// The land's shader, built once for each focus, and
+		// the focus whose shader we're drawing with.
+		std::vector<Shader>		landShaders;
+		unsigned int			landFocus = 0;
+
+		/*-----------------------------------------------*/
+		/* Draw Commands */
+		/*-----------------------------------------------*/
+		/*
+			The chunks to be drawn this frame, which are
+			rewritten into the indirect buffer each time.
+		*/
+		std::vector<DrawCommand>	commands;
+		GLuint					indirectBuffer;
+
+		// The chunks which survived culling.
+		std::vector<unsigned int>	visible;
+
+		// The ocean patches to be drawn with each of the
+		// ocean's meshes, and all of them one after another.
+		std::vector<std::vector<OceanInstance>>	oceanLevels;
+		std::vector<OceanInstance>	oceanInstances;
+
+		// Which chunks were last drawn from their coarse meshes.
+		std::vector<bool>		coarse;
+
+		/*-----------------------------------------------*/
+		/* Palettes */
+		/*-----------------------------------------------*/
+		/*
+			The biome and plate colors, as a uniform buffer
+			laid out the way base.vert's Palettes block is
+			(std140, so each color takes up a whole vec4),
+			and the population and language colors, which are
+			too many for one and go in a storage buffer.
+			They're only uploaded again when the palette
+			version in Settings moves on.
+		*/
+		GLuint					paletteBuffer;
+		GLuint					identityBuffer;
+		unsigned int			paletteVersion = 0;
+
+		void					UpdatePalettes();
 
 	public:
 		/*-----------------------------------------------*/
@@ -3,12 +3,28 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <iterator>
+#include <algorithm>
+#include <filesystem>
 
+#include <GLFW/glfw3.h>
 #include <glm/gtc/type_ptr.hpp>
 
+// From GL_KHR_parallel_shader_compile, which our loader
+// doesn't necessarily know about.
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
 namespace Mandalin
 {
-	Shader::Shader(const char* vertexPath, const char* fragmentPath)
+	const char* Shader::CacheDirectory = "cache/shaders/";
+	bool Shader::parallelCompile = false;
+
+	/*-----------------------------------------------*/
+	/* Constructor */
+	/*-----------------------------------------------*/
+	Shader::Shader(const char* vertexPath, const char* fragmentPath, const std::string& defines)
 	{
 		std::string vertexCode;
 		std::string fragmentCode;
@@ -39,93 +55,301 @@ namespace Mandalin
 			std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ in " << vertexPath << " or " << fragmentPath << '\n';
 		}
 
-		const char* vertexShaderCode = vertexCode.c_str();
-		const char* fragmentShaderCode = fragmentCode.c_str();
+		if (!defines.empty())
+		{
+			for (std::string* code : { &vertexCode, &fragmentCode })
+			{
+				size_t afterVersion = code->find('\n') + 1;
+				code->insert(afterVersion, defines);
+			}
+		}
 
-		GLuint vertex;
-		GLuint fragment;
+		/*
+			If we've built this exact program on this exact driver
+			before, we can skip straight to the binary it gave us.
+		*/
+		ID = glCreateProgram();
 
-		int success;
-		char infoLog[512];
+		std::string key = DriverString() + '\0' + vertexCode + '\0' + fragmentCode;
+		cachePath = CacheDirectory + HashName(key) + ".bin";
+
+		if (LoadBinary()) return;
+
+		/*
+			Otherwise, we start compiling and linking, but don't
+			ask how it went until the program is first needed (see
+			Finish). That leaves the driver free to work on every
+			shader we ask for at once, on other threads if it can.
+		*/
+		EnableParallelCompile();
+
+		const char* vertexShaderCode = vertexCode.c_str();
+		const char* fragmentShaderCode = fragmentCode.c_str();
 
 		// Vertex Shader
 		vertex = glCreateShader(GL_VERTEX_SHADER);
 		glShaderSource(vertex, 1, &vertexShaderCode, NULL);
 		glCompileShader(vertex);
 
-		glGetShaderiv(vertex, GL_COMPILE_STATUS, &success);
-		if (!success)
-		{
-			glGetShaderInfoLog(vertex, 512, NULL, infoLog);
-			std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED" << "\n" << infoLog << '\n';
-		}
-
 		// Fragment Shader
 		fragment = glCreateShader(GL_FRAGMENT_SHADER);
 		glShaderSource(fragment, 1, &fragmentShaderCode, NULL);
 		glCompileShader(fragment);
 
-		glGetShaderiv(fragment, GL_COMPILE_STATUS, &success);
-		if (!success)
-		{
-			glGetShaderInfoLog(fragment, 512, NULL, infoLog);
-			std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED" << "\n" << infoLog << '\n';
-		}
-
 		// Program
-		ID = glCreateProgram();
 		glAttachShader(ID, vertex);
 		glAttachShader(ID, fragment);
+		glProgramParameteri(ID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
 		glLinkProgram(ID);
+	}
 
-		glGetProgramiv(ID, GL_LINK_STATUS, &success);
-		if (!success)
+	/*-----------------------------------------------*/
+	/* Compilation */
+	/*-----------------------------------------------*/
+	void Shader::EnableParallelCompile()
+	{
+		static bool checked = false;
+		if (checked) return;
+		checked = true;
+
+		parallelCompile = glfwExtensionSupported("GL_KHR_parallel_shader_compile");
+		if (!parallelCompile) return;
+
+		// Let the driver use as many threads as it likes.
+		typedef void (APIENTRY* MaxShaderCompilerThreads)(GLuint count);
+		MaxShaderCompilerThreads maxThreads = (MaxShaderCompilerThreads)glfwGetProcAddress("glMaxShaderCompilerThreadsKHR");
+		if (maxThreads) maxThreads(0xFFFFFFFF);
+	}
+
+	bool Shader::Ready()
+	{
+		if (finished) return true;
+
+		// Without the extension there's no asking, so we just
+		// wait for it here.
+		GLint done = GL_TRUE;
+		if (parallelCompile) glGetProgramiv(ID, GL_COMPLETION_STATUS_KHR, &done);
+		if (done != GL_TRUE) return false;
+
+		Finish();
+		return true;
+	}
+
+	void Shader::Finish()
+	{
+		if (finished) return;
+		finished = true;
+
+		int success;
+		char infoLog[512];
+
+		// A program loaded from the cache has no shaders
+		// left to check on.
+		if (vertex != 0)
+		{
+			glGetShaderiv(vertex, GL_COMPILE_STATUS, &success);
+			if (!success)
+			{
+				glGetShaderInfoLog(vertex, 512, NULL, infoLog);
+				std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED" << "\n" << infoLog << '\n';
+			}
+
+			glGetShaderiv(fragment, GL_COMPILE_STATUS, &success);
+			if (!success)
+			{
+				glGetShaderInfoLog(fragment, 512, NULL, infoLog);
+				std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED" << "\n" << infoLog << '\n';
+			}
+
+			glGetProgramiv(ID, GL_LINK_STATUS, &success);
+			if (!success)
+			{
+				glGetProgramInfoLog(ID, 512, NULL, infoLog);
+				std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << '\n';
+			}
+			else
+			{
+				SaveBinary();
+			}
+
+			glDetachShader(ID, vertex);
+			glDetachShader(ID, fragment);
+			glDeleteShader(vertex);
+			glDeleteShader(fragment);
+			vertex = 0;
+			fragment = 0;
+		}
+
+		// Uniforms
+		int uniformCount;
+		glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &uniformCount);
+
+		for (int i = 0; i < uniformCount; i++)
+		{
+			char name[256];
+			GLsizei length;
+			GLint size;
+			GLenum type;
+
+			glGetActiveUniform(ID, i, sizeof(name), &length, &size, &type, name);
+
+			// Arrays are listed by their first element.
+			std::string uniformName(name, length);
+			if (uniformName.size() > 3 && uniformName.compare(uniformName.size() - 3, 3, "[0]") == 0) uniformName.resize(uniformName.size() - 3);
+
+			GLint location = glGetUniformLocation(ID, name);
+			if (location >= 0) uniforms[uniformName] = { location, {} };
+		}
+	}
+
+	/*-----------------------------------------------*/
+	/* Program Cache */
+	/*-----------------------------------------------*/
+	/*
+		Each cached program is a file named after a hash of
+		its sources and the driver that built it, holding
+		the binary's format followed by the binary itself.
+		A new driver (or any change to a shader) just means
+		a new name, so nothing stale is ever loaded.
+	*/
+	std::string Shader::DriverString()
+	{
+		std::string driver;
+
+		for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION })
 		{
-			glGetProgramInfoLog(ID, 512, NULL, infoLog);
-			std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << '\n';
+			const GLubyte* value = glGetString(name);
+			if (value) driver += (const char*)value;
+			driver += '\n';
 		}
 
-		glDeleteShader(vertex);
-		glDeleteShader(fragment);
+		return driver;
 	}
 
+	std::string Shader::HashName(const std::string& key)
+	{
+		// FNV-1a, 64 bits.
+		unsigned long long hash = 14695981039346656037ULL;
+
+		for (unsigned char c : key)
+		{
+			hash ^= c;
+			hash *= 1099511628211ULL;
+		}
+
+		std::stringstream name;
+		name << std::hex << hash;
+		return name.str();
+	}
+
+	bool Shader::LoadBinary()
+	{
+		int formatCount = 0;
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+		if (formatCount == 0) return false;
+
+		std::ifstream file(cachePath, std::ios::binary);
+		if (!file) return false;
+
+		GLenum format;
+		if (!file.read((char*)&format, sizeof(format))) return false;
+
+		std::vector<char> binary((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+		if (binary.empty()) return false;
+
+		glProgramBinary(ID, format, binary.data(), binary.size());
+
+		// The driver is allowed to turn down any binary at all,
+		// in which case we compile as though it weren't there.
+		int success;
+		glGetProgramiv(ID, GL_LINK_STATUS, &success);
+		if (!success) return false;
+
+		Finish();
+		return true;
+	}
+
+	void Shader::SaveBinary()
+	{
+		GLint length = 0;
+		glGetProgramiv(ID, GL_PROGRAM_BINARY_LENGTH, &length);
+		if (length <= 0) return;
+
+		std::vector<char> binary(length);
+		GLenum format;
+		glGetProgramBinary(ID, length, NULL, &format, binary.data());
+
+		std::error_code error;
+		std::filesystem::create_directories(CacheDirectory, error);
+
+		std::ofstream file(cachePath, std::ios::binary);
+		if (!file) return;
+
+		file.write((const char*)&format, sizeof(format));
+		file.write(binary.data(), binary.size());
+	}
+
+	/*-----------------------------------------------*/
+	/* Use */
+	/*-----------------------------------------------*/
 	void Shader::Use()
 	{
+		Finish();
 		glUseProgram(ID);
 	}
 
-	void Shader::SetBool(const std::string& name, bool value) const
+	/*-----------------------------------------------*/
+	/* Uniforms */
+	/*-----------------------------------------------*/
+	Shader::Uniform* Shader::Changed(const std::string& name, const void* value, size_t size)
+	{
+		Finish();
+
+		auto found = uniforms.find(name);
+		if (found == uniforms.end()) return nullptr;
+
+		Uniform* uniform = &found->second;
+		const unsigned char* bytes = (const unsigned char*)value;
+
+		if (uniform->value.size() == size && std::equal(bytes, bytes + size, uniform->value.begin())) return nullptr;
+
+		uniform->value.assign(bytes, bytes + size);
+		return uniform;
+	}
+
+	void Shader::SetBool(const std::string& name, bool value)
 	{
-		glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+		int v = (int)value;
+		if (Uniform* u = Changed(name, &v, sizeof(v))) glUniform1i(u->location, v);
 	}
 
-	void Shader::SetInt(const std::string& name, int value) const
+	void Shader::SetInt(const std::string& name, int value)
 	{
-		glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+		if (Uniform* u = Changed(name, &value, sizeof(value))) glUniform1i(u->location, value);
 	}
 
-	void Shader::SetFloat(const std::string& name, float value) const
+	void Shader::SetFloat(const std::string& name, float value)
 	{
-		glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+		if (Uniform* u = Changed(name, &value, sizeof(value))) glUniform1f(u->location, value);
 	}
 
-	void Shader::SetMatrix(const std::string& name, const glm::mat4& value) const
+	void Shader::SetMatrix(const std::string& name, const glm::mat4& value)
 	{
-		glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, glm::value_ptr(value));
+		if (Uniform* u = Changed(name, glm::value_ptr(value), 16 * sizeof(float))) glUniformMatrix4fv(u->location, 1, GL_FALSE, glm::value_ptr(value));
 	}
 
-	void Shader::SetVector3(const std::string& name, const glm::vec3& value) const
+	void Shader::SetVector3(const std::string& name, const glm::vec3& value)
 	{
-		glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, glm::value_ptr(value));
+		if (Uniform* u = Changed(name, glm::value_ptr(value), 3 * sizeof(float))) glUniform3fv(u->location, 1, glm::value_ptr(value));
 	}
 
-	void Shader::SetVector4(const std::string& name, const glm::vec4& value) const
+	void Shader::SetVector4(const std::string& name, const glm::vec4& value)
 	{
-		glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, glm::value_ptr(value));
+		if (Uniform* u = Changed(name, glm::value_ptr(value), 4 * sizeof(float))) glUniform4fv(u->location, 1, glm::value_ptr(value));
 	}
 
-	void Shader::SetVector4Arr(const std::string& name, const glm::vec4& value, const int& size) const
+	void Shader::SetVector4Arr(const std::string& name, const glm::vec4& value, const int& size)
 	{
-		glUniform4fv(glGetUniformLocation(ID, name.c_str()), size, glm::value_ptr(value));
+		if (Uniform* u = Changed(name, glm::value_ptr(value), 4 * sizeof(float) * size)) glUniform4fv(u->location, size, glm::value_ptr(value));
 	}
 }
\ No newline at end of file
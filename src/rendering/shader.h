@@ -2,6 +2,8 @@
 #define SHADER_H
 
 #include <string>
+#include <vector>
+#include <unordered_map>
 
 #include <glad/glad.h>
 #include <glm/glm.hpp>
@@ -10,20 +12,80 @@ namespace Mandalin
 {
 	class Shader
 	{
+	private:
+		/*
+			Every uniform the program uses, looked up once
+			when it's linked. Each keeps whatever it was last
+			set to, so setting it to the same thing again (as
+			most of them are, frame after frame) never has to
+			go to OpenGL at all.
+		*/
+		struct Uniform
+		{
+			GLint						location;
+			std::vector<unsigned char>	value;
+		};
+
+		std::unordered_map<std::string, Uniform>	uniforms;
+
+		/*
+			The program is compiled and linked in the background
+			(if the driver will) and only checked on, which waits
+			for it to be done, the first time it's needed.
+		*/
+		GLuint					vertex = 0;
+		GLuint					fragment = 0;
+		bool					finished = false;
+
+		static bool				parallelCompile;
+		static void				EnableParallelCompile();
+
+		void					Finish();
+
+		/*
+			Linked programs are saved to disk and loaded back
+			the next time the same sources are built on the
+			same driver.
+		*/
+		static const char*		CacheDirectory;
+		std::string				cachePath;
+
+		static std::string		DriverString();
+		static std::string		HashName(const std::string& key);
+
+		bool					LoadBinary();
+		void					SaveBinary();
+
+		// Returns the uniform if it exists and isn't already
+		// set to the given value, and nullptr otherwise.
+		Uniform* Changed(const std::string& name, const void* value, size_t size);
+
 	public:
 		GLuint ID;
 
-		Shader(const char* vertexPath, const char* fragmentPath);
+		/*
+			Any defines are slipped in just after each stage's
+			#version line, so one source file can be built into
+			several different programs.
+		*/
+		Shader(const char* vertexPath, const char* fragmentPath, const std::string& defines = "");
 
 		void Use();
 
-		void SetBool(const std::string& name, bool value) const;
-		void SetInt(const std::string& name, int value) const;
-		void SetFloat(const std::string& name, float value) const;
-		void SetMatrix(const std::string& name, const glm::mat4& value) const;
-		void SetVector3(const std::string& name, const glm::vec3& value) const;
-		void SetVector4(const std::string& name, const glm::vec4& value) const;
-		void SetVector4Arr(const std::string& name, const glm::vec4& value, const int& size) const;
+		/*
+			Whether the program can be used without waiting on
+			the driver to finish building it. Once it can, it's
+			checked and saved to the cache right away.
+		*/
+		bool Ready();
+
+		void SetBool(const std::string& name, bool value);
+		void SetInt(const std::string& name, int value);
+		void SetFloat(const std::string& name, float value);
+		void SetMatrix(const std::string& name, const glm::mat4& value);
+		void SetVector3(const std::string& name, const glm::vec3& value);
+		void SetVector4(const std::string& name, const glm::vec4& value);
+		void SetVector4Arr(const std::string& name, const glm::vec4& value, const int& size);
 	};
 }
 
@@ -7,26 +7,54 @@ namespace Mandalin
 	/*-------------------------------------------------*/
 	/* Populations                                     */
 	/*-------------------------------------------------*/
-	void History::PopulationSplit(Population* population, Hex* origin)
+	void History::AddSubpopulation(unsigned int population, Hex* hex, double share)
 	{
-		double ratio = ((rand() % 35 + 1) + 15.0) / 100.0;
+		hex->subpopulations.push_back({ population, share });
+		populations[population].domain.push_back(hex);
+	}
+
+	void History::RemoveSubpopulation(unsigned int population, Hex* hex)
+	{
+		for (int i = 0; i < hex->subpopulations.size(); i++)
+		{
+			if (hex->subpopulations[i].population != population) continue;
+
+			hex->subpopulations[i] = hex->subpopulations.back();
+			hex->subpopulations.pop_back();
+			break;
+		}
 
-		unsigned int nHex = floor(population->domain * ratio);
+		std::vector<Hex*>* domain = &populations[population].domain;
+
+		for (int i = 0; i < domain->size(); i++)
+		{
+			if ((*domain)[i] != hex) continue;
+
+			(*domain)[i] = domain->back();
+			domain->pop_back();
+			break;
+		}
+	}
+
+	void History::PopulationSplit(unsigned int population, Hex* origin, Random& rng)
+	{
+		double ratio = ((rng.Range(35) + 1) + 15.0) / 100.0;
+
+		unsigned int nHex = floor(populations[population].domain.size() * ratio);
 
 		if (nHex == 0) return;
 
-		int popID = rand() % 10000 + 1;
+		int popID = rng.Range(10000) + 1;
 
 		Population newPopulation =
 		{
 			popID,
 			{ 0 },
-			nHex,
 			{ }
 		};
 
-		population->domain -= nHex;
 		populations.push_back(newPopulation);
+		unsigned int newPop = populations.size() - 1;
 
 		// Now, we're going to flood-fill a number of hexes from the origin
 		// and add these to our new population, removing them from the old one.
@@ -43,13 +71,13 @@ namespace Mandalin
 			{
 				Hex* hex = searchArea[i];
 
-				for (int j = 0; j < hex->neighbors.size(); j++)
+				for (int j = 0; j < planet->NeighborCount(hex); j++)
 				{
-					Hex* n = planet->GetHex(hex->neighbors[j].first, hex->neighbors[j].second);
+					Hex* n = planet->GetNeighbor(hex, j);
 
 					if (n->checked != -1) continue;
 
-					if (population->subpopulations.find(n) != population->subpopulations.end() && number < nHex)
+					if (n->FindSubpopulation(population) != nullptr && number < nHex)
 					{
 						number++;
 						n->checked = 1;
@@ -66,19 +94,23 @@ namespace Mandalin
 		for (int i = 0; i < searchArea.size(); i++)
 		{
 			Hex* hex = searchArea[i];
+			Subpopulation* sp = hex->FindSubpopulation(population);
+
+			if (sp != nullptr)
+			{
+				double share = sp->share;
 
-			newPopulation.subpopulations[hex] = population->subpopulations[hex];
-			population->subpopulations.erase(hex);
+				RemoveSubpopulation(population, hex);
+				AddSubpopulation(newPop, hex, share);
+			}
 
 			CheckPopulation(hex);
 
 			hex->checked = -1;
 		}
-
-		populations.push_back(newPopulation);
 	}
 
-	void History::MoveSubpopulation(Hex* origin, Hex* destination, unsigned int women, unsigned int men)
+	void History::MoveSubpopulation(Hex* origin, Hex* destination, unsigned int women, unsigned int men, Random& rng)
 	{
 		// First, let's grab save some variables for later use.
 		unsigned int originOldPop = origin->Population();
@@ -98,89 +130,77 @@ namespace Mandalin
 		// update the percentage of each population that belongs
 		// to them.
 		double migrantPerc = (women + men) / destination->Population();
-		double dilution = migrantPerc / destination->subpopCount;
-		double concentration = migrantPerc / origin->subpopCount;
+		double dilution = migrantPerc / destination->SubpopCount();
+		double concentration = migrantPerc / origin->SubpopCount();
 
 		unsigned int blockedPops = 0;
 
-		for (int i = 0; i < populations.size(); i++)
+		// If a population is a pre-existing one at the destination,
+		// we need to see how much its percentage of the population is
+		// diluted by the arrival of these new people.
+		for (int i = destination->SubpopCount() - 1; i >= 0; i--)
 		{
-			Population* p = &populations[i];
+			Subpopulation* sp = &destination->subpopulations[i];
 
-			if (p->subpopulations.find(destination) != p->subpopulations.end())
-			{
-				// If this population is a pre-existing one at the destination,
-				// we need to see how much its percentage of the population is
-				// diluted by the arrival of these new people.
+			sp->share -= dilution;
 
-				p->subpopulations[destination] -= dilution;
+			if (sp->share <= 0) RemoveSubpopulation(sp->population, destination);
+		}
 
-				if (p->subpopulations[destination] <= 0)
-				{
-					p->domain--;
-					destination->subpopCount--;
-					p->subpopulations.erase(destination);
-				}
-			}
-			
-			if (p->subpopulations.find(origin) != p->subpopulations.end())
+		// If a population is departing the origin, we need to see
+		// how much of a percentage they gain in the new location.
+		// Splitting a population can shuffle the origin's list, so
+		// we walk over a copy of it.
+		std::vector<Subpopulation> departing = origin->subpopulations;
+
+		for (int i = 0; i < departing.size(); i++)
+		{
+			unsigned int p = departing[i].population;
+
+			// If the population is too small, just don't migrate it
+			// and add it instead to the blocked pops.
+			if (departing[i].share < 0.1)
 			{
-				// If this population is departing the origin, we need to see
-				// how much of a percentage they gain in the new location.
+				blockedPops++;
+				continue;
+			}
 
-				// If the population is too small, just don't migrate it
-				// and add it instead to the blocked pops.
-				if (p->subpopulations[origin] < 0.1)
-				{
-					blockedPops++;
-					continue;
-				}
+			Subpopulation* existing = destination->FindSubpopulation(p);
 
-				if (p->subpopulations.find(destination) != p->subpopulations.end())
-				{
-					p->subpopulations[destination] += concentration;
-				}
-				else if (p->domain < Settings::DomainLimit - 1)
-				{
-					p->domain++;
-					destination->subpopCount++;
-					p->subpopulations[destination] = concentration;
-				}
-				else // if (p->domain == Settings::DomainLimit)
-				{
-					p->domain++;
-					destination->subpopCount++;
-					p->subpopulations[destination] = concentration;
-					PopulationSplit(p, origin);
-				}
-				//else
-				//{
-				//	// Here, we're dealing with a population that has reached
-				//	// its domain limit which causes some zaney weirdness. We
-				//	// have to go back and adjust the other populations to 
-				//	// account for the fact that we can't add this pop to these
-				//	// others.
-
-				//	blockedPops++;
-
-				//	// We need to check if ethnogenesis occurs which sometimes
-				//	// happens when a population spreads itself too thin.
-				//}
+			if (existing != nullptr)
+			{
+				existing->share += concentration;
 			}
+			else if (populations[p].domain.size() < Settings::DomainLimit - 1)
+			{
+				AddSubpopulation(p, destination, concentration);
+			}
+			else // if (p->domain == Settings::DomainLimit)
+			{
+				AddSubpopulation(p, destination, concentration);
+				PopulationSplit(p, origin, rng);
+			}
+			//else
+			//{
+			//	// Here, we're dealing with a population that has reached
+			//	// its domain limit which causes some zaney weirdness. We
+			//	// have to go back and adjust the other populations to 
+			//	// account for the fact that we can't add this pop to these
+			//	// others.
+
+			//	blockedPops++;
+
+			//	// We need to check if ethnogenesis occurs which sometimes
+			//	// happens when a population spreads itself too thin.
+			//}
 		}
 
 		if (blockedPops > 0)
 		{
-			for (int i = 0; i < populations.size(); i++)
+			for (int i = 0; i < destination->SubpopCount(); i++)
 			{
-				Population* p = &populations[i];
-
-				if (p->subpopulations.find(destination) != p->subpopulations.end())
-				{
-					p->subpopulations[destination] += (concentration / (double)blockedPops);
-				}
+				destination->subpopulations[i].share += (concentration / (double)blockedPops);
 			}
-
 		}
 
 		CheckPopulation(origin);
@@ -188,7 +208,7 @@ namespace Mandalin
 	}
 
 	// Returns true if successful and false if a failure.
-	void History::ProximalMigration(Hex* origin, unsigned int nWomen, unsigned int nMen)
+	void History::ProximalMigration(Hex* origin, unsigned int nWomen, unsigned int nMen, Random& rng)
 	{
 		/*
 			A proximal migration, as opposed to a medial or distal migration,
@@ -207,9 +227,9 @@ namespace Mandalin
 
 		int bestImmediateScore = 0;
 
-		for (int i = 0; i < origin->neighbors.size(); i++)
+		for (int i = 0; i < planet->NeighborCount(origin); i++)
 		{
-			Hex* n = planet->GetHex(origin->neighbors[i].first, origin->neighbors[i].second);
+			Hex* n = planet->GetNeighbor(origin, i);
 
 			if (n->checked == -1 && n->biome != Biome::ocean)
 			{
@@ -234,9 +254,9 @@ namespace Mandalin
 				{
 					Hex* h = searchArea[j];
 
-					for (int k = 0; k < h->neighbors.size(); k++)
+					for (int k = 0; k < planet->NeighborCount(h); k++)
 					{
-						Hex* n = planet->GetHex(h->neighbors[k].first, h->neighbors[k].second);
+						Hex* n = planet->GetNeighbor(h, k);
 
 						if (n->checked == -1 && n->biome != Biome::ocean)
 						{
@@ -278,16 +298,16 @@ namespace Mandalin
 			return;
 		}
 
-		double r = 0.5 + (((rand() % 20 + 1) / 100.0) - 0.1);
+		double r = 0.5 + (((rng.Range(20) + 1) / 100.0) - 0.1);
 
 		int women = ceil(number * r);
 		int men = number - women;
 
-		// std::cout << "Moving " << women << " women and " << men << " men from (" << origin->chunk << " / " << origin->index << ") to (" << destination->chunk << ") / (" << destination->index << ")." << std::endl;
-		if (women + men > 0) MoveSubpopulation(origin, destination, women, men);
+		// std::cout << "Moving " << women << " women and " << men << " men from (" << origin->id << ") to (" << destination->id << ")." << std::endl;
+		if (women + men > 0) MoveSubpopulation(origin, destination, women, men, rng);
 	}
 
-	void History::GrowPopulation(Hex* hex)
+	bool History::GrowPopulation(Hex* hex, Random& rng)
 	{
 		unsigned int oldPop = hex->Population();
 
@@ -301,7 +321,7 @@ namespace Mandalin
 
 			int dPop = (Settings::BaseRateOfNaturalIncrease * roiMod) * oldPop * (1.0 - ((float)oldPop / hex->lcc));
 
-			double ratio = 0.5 + ((rand() % 10 + 1) / 100.0);
+			double ratio = 0.5 + ((rng.Range(10) + 1) / 100.0);
 
 			dWomen = floor(dPop * ratio);
 			dMen = dPop - dWomen;
@@ -326,106 +346,134 @@ namespace Mandalin
 		if ((int)hex->population.second + dMen <= 0) hex->population.second = 0;
 		else hex->population.second += dMen;
 
-		if (hex->Population() <= 0)
-		{
-			for (int i = 0; i < populations.size(); i++)
-			{
-				Population* p = &populations[i];
-
-				if (p->subpopulations.find(hex) != p->subpopulations.end())
-				{
-					p->domain--;
-					p->subpopulations.erase(hex);
-				}
-			}
+		return (hex->Population() <= 0);
+	}
 
-			hex->subpopCount = 0;
-			CheckPopulation(hex);
+	void History::ClearPopulation(Hex* hex)
+	{
+		while (!hex->subpopulations.empty())
+		{
+			RemoveSubpopulation(hex->subpopulations.back().population, hex);
 		}
+
+		CheckPopulation(hex);
 	}
 
 	void History::CheckPopulation(Hex* hex)
 	{
 		// If this hex is not populated, we made a mistake by calling this.
-		if (hex->Population() == 0) planet->SetPopulation(hex->chunk, hex->index, 0);
+		if (hex->Population() == 0) planet->SetPopulation(hex->id, 0);
 
 		// Otherwise, we've gotta see who is the biggest.
 		double largestSubpopulation = 0;
 		unsigned int largestSubpopID = 0;
 
-		for (int i = 0; i < populations.size(); i++)
+		for (int i = 0; i < hex->SubpopCount(); i++)
 		{
-			Population* p = &populations[i];
+			Subpopulation* sp = &hex->subpopulations[i];
 
-			if (p->subpopulations.find(hex) != p->subpopulations.end())
+			if (sp->share > largestSubpopulation)
 			{
-				double subPerc = p->subpopulations[hex];
-
-				if (subPerc > largestSubpopulation)
-				{
-					largestSubpopulation = subPerc;
-					largestSubpopID = p->id;
-				}
+				largestSubpopulation = sp->share;
+				largestSubpopID = populations[sp->population].id;
 			}
 		}
 
-		planet->SetPopulation(hex->chunk, hex->index, largestSubpopID);
+		planet->SetPopulation(hex->id, largestSubpopID);
 	}
 
 	/*-------------------------------------------------*/
 	/* Update                                          */
 	/*-------------------------------------------------*/
-	void History::OverflowPopulation(Hex* hex)
+	MigrationIntent History::OverflowPopulation(Hex* hex, Random& rng)
 	{
 		// We're going to trigger a migration.
 		unsigned int n = ceil(hex->Population() - (hex->lcc * 0.85));
-		double ratio = 0.5 + ((rand() % 10 + 1) / 100.0);
+		double ratio = 0.5 + ((rng.Range(10) + 1) / 100.0);
 
 		unsigned int nWomen = floor(n * ratio);
 		unsigned int nMen = n - nWomen;
 
-		// For now, this only involves proximal migrations,
-		// but at some point I'd like to add medial and distal
-		// migrations here as well.
-		ProximalMigration(hex, nWomen, nMen);
+		return { hex, nWomen, nMen, rng };
 	}
 
 	void History::UpdatePopulation()
 	{
-		srand(time(NULL));
+		tick++;
 
 		/*
-			First, we're going to go through and update the population
-			of each inhabited hex.
+			First, we're going to go through and grow the population
+			of each inhabited hex. Growth only ever touches the hex
+			itself, so the chunks can be handed out to the workers.
+			Anything which reaches beyond the hex (migrations and
+			populations dying out) is written down to be dealt with
+			afterwards.
+
+			Each hex draws from its own stream keyed by the tick and
+			its id, so it makes no difference which thread gets to
+			it or in which order.
 		*/
 		unsigned int cn = planet->ChunkCount();
 
-		for (int i = 0; i < cn; i++)
+		migrations.resize(cn);
+		extinctions.resize(cn);
+
+		workers->ParallelFor(cn, [&](unsigned int i)
 		{
 			Chunk* c = planet->GetChunk(i);
 			unsigned int hn = c->hexCount;
 
+			migrations[i].clear();
+			extinctions[i].clear();
+
 			for (int j = 0; j < hn; j++)
 			{
-				Hex* h = &c->hexes[j];
+				Hex* h = planet->GetHex(c->hexStart + j);
+
+				if (h->population.first == 0 && h->population.second == 0) continue;
 
-				if (h->population.first != 0 || h->population.second != 0)
+				Random rng(seed, tick, c->hexStart + j);
+
+				if (GrowPopulation(h, rng))
 				{
-					GrowPopulation(h);
+					extinctions[i].push_back(h);
+					continue;
+				}
 
-					// Here, we're gonna see if any migrations are
-					// triggered due to populations reaching land carrying
-					// capacity limits.
+				// Here, we're gonna see if any migrations are
+				// triggered due to populations reaching land carrying
+				// capacity limits.
 
-					// double ran = rand() % 100 + 1;
-					double r = (rand() % 15 + 1) / 100.0;
+				// double ran = rand() % 100 + 1;
+				double r = (rng.Range(15) + 1) / 100.0;
 
-					if ((h->Population() / (double)h->lcc >= 1.0 - r)) // && ran > 75)
-					{
-						OverflowPopulation(h);
-					}
+				if ((h->Population() / (double)h->lcc >= 1.0 - r)) // && ran > 75)
+				{
+					migrations[i].push_back(OverflowPopulation(h, rng));
 				}
 			}
+		});
+
+		/*
+			Now we settle everything that was written down, always
+			in the same order: chunk by chunk, hex by hex.
+		*/
+		for (int i = 0; i < cn; i++)
+		{
+			for (int j = 0; j < extinctions[i].size(); j++) ClearPopulation(extinctions[i][j]);
+		}
+
+		for (int i = 0; i < cn; i++)
+		{
+			for (int j = 0; j < migrations[i].size(); j++)
+			{
+				MigrationIntent* m = &migrations[i][j];
+
+				// For now, this only involves proximal migrations,
+				// but at some point I'd like to add medial and distal
+				// migrations here as well.
+				ProximalMigration(m->origin, m->women, m->men, m->rng);
+			}
 		}
 	}
 
@@ -455,10 +503,15 @@ namespace Mandalin
 	/*-------------------------------------------------*/
 	History::History(Planet* planet)
 	{
-		srand(time(NULL));
-
 		this->planet = planet;
 
+		this->seed = planet->GetSeed().StageSeed(SeedStage::history);
+		this->tick = 0;
+
+		this->workers = new WorkerPool(Settings::SimulationThreads);
+
+		Random rng(seed, tick, 0);
+
 		this->day = 1;
 		this->month = 1;
 		this->year = 1;
@@ -468,7 +521,7 @@ namespace Mandalin
 
 		for (int z = 0; z < Settings::NumberOfStartingPopulations; z++)
 		{
-			int c = rand() % planet->ChunkCount();
+			int c = rng.Range(planet->ChunkCount());
 			Chunk* chunk = planet->GetChunk(c);
 
 			int h;
@@ -476,8 +529,8 @@ namespace Mandalin
 
 			while (true)
 			{
-				h = rand() % chunk->hexCount;
-				hex = &chunk->hexes[h];
+				h = rng.Range(chunk->hexCount);
+				hex = planet->GetHex(chunk->hexStart + h);
 
 				if (hex->biome != Biome::ocean) break;
 
@@ -489,23 +542,27 @@ namespace Mandalin
 			attempts = 0;
 			if (hex->biome == Biome::ocean) continue;
 
-			int popID = rand() % 10000 + 1;
+			int popID = rng.Range(10000) + 1;
 
 			Population pop =
 			{
 				popID,
 				{ 0 },
-				1,
 				{ }
 			};
 
-			pop.subpopulations[hex] = 1.0;
+			populations.push_back(pop);
+			AddSubpopulation(populations.size() - 1, hex, 1.0);
+
 			hex->population.first += 50;
 			hex->population.second += 50;
-			hex->subpopCount++;
 
-			populations.push_back(pop);
 			CheckPopulation(hex);
 		}
 	}
+
+	History::~History()
+	{
+		delete workers;
+	}
 }
\ No newline at end of file
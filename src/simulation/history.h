@@ -5,9 +5,27 @@
 
 #include "population.h"
 #include "../world/planet.h"
+#include "../util/random.h"
+#include "../util/workerpool.h"
 
 namespace Mandalin
 {
+	/*----------------------------------------------------------------------*/
+	/* Migration Intent                                                     */
+	/*----------------------------------------------------------------------*/
+	/*
+		A migration which a hex has decided on while the populations
+		were growing but which has yet to actually happen. It keeps
+		the hex's random stream so that it picks up where it left off.
+	*/
+	struct MigrationIntent
+	{
+		Hex*													origin;
+		unsigned int											women;
+		unsigned int											men;
+		Random													rng;
+	};
+
 	class History
 	{
 	private:
@@ -28,23 +46,51 @@ namespace Mandalin
 		/*----------------------------------------------------------------------*/
 		std::vector<Population>									populations;
 
-		void													MoveSubpopulation(Hex* origin, Hex* destination, unsigned int women, unsigned int men);
+		void													AddSubpopulation(unsigned int population, Hex* hex, double share);
+		void													RemoveSubpopulation(unsigned int population, Hex* hex);
+
+		void													MoveSubpopulation(Hex* origin, Hex* destination, unsigned int women, unsigned int men, Random& rng);
 		
-		void													ProximalMigration(Hex* hex, unsigned int nWomen, unsigned int nMen);
+		void													ProximalMigration(Hex* hex, unsigned int nWomen, unsigned int nMen, Random& rng);
 		// void													MedialMigration(Population* population, Hex* hex, unsigned int number);
 		// void													DistalMigration(Population* population, Hex* hex, unsigned int number);
 
-		void													PopulationSplit(Population* population, Hex* origin);
-		void													OverflowPopulation(Hex* hex);
-		void													GrowPopulation(Hex* hex);
+		void													PopulationSplit(unsigned int population, Hex* origin, Random& rng);
+		MigrationIntent											OverflowPopulation(Hex* hex, Random& rng);
+		bool													GrowPopulation(Hex* hex, Random& rng);
+		void													ClearPopulation(Hex* hex);
 		void													CheckPopulation(Hex* hex);
 
+		/*----------------------------------------------------------------------*/
+		/* Ticks                                                                */
+		/*----------------------------------------------------------------------*/
+		/*
+			Every random number the simulation draws is keyed by
+			the seed, the tick, and (usually) a hex, so the outcome
+			doesn't depend on how many workers split the work.
+		*/
+		uint64_t												seed;
+		uint64_t												tick;
+
+		WorkerPool*												workers;
+
+		// Per-chunk lists filled in while populations grow.
+		std::vector<std::vector<MigrationIntent>>				migrations;
+		std::vector<std::vector<Hex*>>							extinctions;
+
 		/*----------------------------------------------------------------------*/
 		/* Planet                                                               */
 		/*----------------------------------------------------------------------*/
 		Planet*													planet;
 
 	public:
+		/*----------------------------------------------------------------------*/
+		/* Chronology, Cont.                                                    */
+		/*----------------------------------------------------------------------*/
+		unsigned int											GetDay() { return day; }
+		unsigned int											GetMonth() { return month; }
+		unsigned int											GetYear() { return year; }
+
 		/*----------------------------------------------------------------------*/
 		/* Update                                                               */
 		/*----------------------------------------------------------------------*/
@@ -55,6 +101,7 @@ namespace Mandalin
 		/* Constructor                                                          */
 		/*----------------------------------------------------------------------*/
 		History(Planet* planet);
+		~History();
 	};
 }
 
@@ -13,9 +13,10 @@ namespace Mandalin
 
 		std::vector<unsigned int>						languages;
 
-		unsigned int									domain;
-		// This double is the percentage of a hex that a population makes up.
-		std::unordered_map<Hex*, double>				subpopulations;
+		// The hexes this population has a share of. Each of these
+		// hexes lists the population in its subpopulations, which
+		// is where the percentage of the hex it makes up is kept.
+		std::vector<Hex*>								domain;
 	};
 }
 
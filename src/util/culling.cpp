@@ -0,0 +1,278 @@
+#include "culling.h"
+
+#include <limits>
+#include <algorithm>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define CULLING_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace Mandalin
+{
+	/*-----------------------------------------------*/
+	/* Bounds */
+	/*-----------------------------------------------*/
+	BoundingSphere BuildBoundingSphere(const std::vector<glm::vec3>& points)
+	{
+		if (points.empty()) return { glm::vec3(0.0f, 0.0f, 0.0f), 0.0f };
+
+		glm::vec3 low = points[0];
+		glm::vec3 high = points[0];
+
+		for (int i = 1; i < points.size(); i++)
+		{
+			low = glm::min(low, points[i]);
+			high = glm::max(high, points[i]);
+		}
+
+		BoundingSphere sphere = { (low + high) / 2.0f, 0.0f };
+
+		for (int i = 0; i < points.size(); i++)
+		{
+			sphere.radius = std::max(sphere.radius, glm::length(points[i] - sphere.center));
+		}
+
+		return sphere;
+	}
+
+	NormalCone BuildNormalCone(glm::vec3 axis, const std::vector<glm::vec3>& normals)
+	{
+		axis = glm::normalize(axis);
+
+		float lowest = 1.0f;
+		for (int i = 0; i < normals.size(); i++)
+		{
+			lowest = std::min(lowest, glm::dot(axis, glm::normalize(normals[i])));
+		}
+
+		// Once the normals spread past a right angle, there is
+		// nowhere to stand where all of them face away.
+		if (lowest <= 0.0f) return { axis, 2.0f };
+
+		return { axis, sqrtf(1.0f - lowest * lowest) };
+	}
+
+	glm::vec3 BuildHorizonPoint(const std::vector<glm::vec3>& points, glm::vec3 occluderCenter, float occluderRadius)
+	{
+		/*
+			For each point, we work out how far along the chunk's
+			direction our stand-in would have to be for it to come
+			over the horizon exactly when that point does, and take
+			the farthest of them.
+
+			If any point is so far off to the side that no such
+			distance exists, the chunk can never be hidden. We mark
+			that with a NaN, since every comparison in the horizon
+			test then comes out false.
+		*/
+		glm::vec3 middle = glm::vec3(0.0f, 0.0f, 0.0f);
+		for (int i = 0; i < points.size(); i++) middle += points[i] - occluderCenter;
+
+		glm::vec3 direction = glm::normalize(middle);
+		float farthest = 0.0f;
+
+		for (int i = 0; i < points.size(); i++)
+		{
+			glm::vec3 scaled = (points[i] - occluderCenter) / occluderRadius;
+
+			float magnitudeSquared = glm::dot(scaled, scaled);
+			float magnitude = sqrtf(magnitudeSquared);
+			glm::vec3 toPoint = scaled / magnitude;
+
+			magnitudeSquared = std::max(1.0f, magnitudeSquared);
+			magnitude = std::max(1.0f, magnitude);
+
+			float cosAlpha = glm::dot(toPoint, direction);
+			float sinAlpha = glm::length(glm::cross(toPoint, direction));
+			float cosBeta = 1.0f / magnitude;
+			float sinBeta = sqrtf(magnitudeSquared - 1.0f) * cosBeta;
+
+			float denominator = cosAlpha * cosBeta - sinAlpha * sinBeta;
+			if (denominator <= 0.0f) return glm::vec3(std::numeric_limits<float>::quiet_NaN());
+
+			farthest = std::max(farthest, 1.0f / denominator);
+		}
+
+		return direction * farthest;
+	}
+
+	/*-----------------------------------------------*/
+	/* Frustum */
+	/*-----------------------------------------------*/
+	Frustum::Frustum(const glm::mat4& viewProjection)
+	{
+		/*
+			Each plane is the last row of the matrix plus or
+			minus one of the others (glm keeps its matrices by
+			column, so m[column][row]).
+		*/
+		glm::vec4 rows[4];
+		for (int i = 0; i < 4; i++)
+		{
+			rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+		}
+
+		for (int i = 0; i < 3; i++)
+		{
+			planes[2 * i] = rows[3] + rows[i];
+			planes[2 * i + 1] = rows[3] - rows[i];
+		}
+
+		for (int i = 0; i < 6; i++)
+		{
+			planes[i] /= glm::length(glm::vec3(planes[i].x, planes[i].y, planes[i].z));
+		}
+	}
+
+	/*-----------------------------------------------*/
+	/* Cull Batch */
+	/*-----------------------------------------------*/
+	void CullBatch::Add(BoundingSphere sphere, NormalCone cone, glm::vec3 horizon)
+	{
+		if (count % 4 == 0)
+		{
+			// Open up room for the next four.
+			for (std::vector<float>* v : { &x, &y, &z, &radius, &axisX, &axisY, &axisZ, &cutoff, &horizonX, &horizonY, &horizonZ })
+			{
+				v->resize(count + 4, 0.0f);
+			}
+		}
+
+		x[count] = sphere.center.x;
+		y[count] = sphere.center.y;
+		z[count] = sphere.center.z;
+		radius[count] = sphere.radius;
+
+		axisX[count] = cone.axis.x;
+		axisY[count] = cone.axis.y;
+		axisZ[count] = cone.axis.z;
+		cutoff[count] = cone.cutoff;
+
+		horizonX[count] = horizon.x;
+		horizonY[count] = horizon.y;
+		horizonZ[count] = horizon.z;
+
+		count++;
+	}
+
+	void CullBatch::Add(BoundingSphere sphere, glm::vec3 horizon)
+	{
+		Add(sphere, { glm::vec3(0.0f, 0.0f, 1.0f), 2.0f }, horizon);
+	}
+
+	void CullBatch::Clear()
+	{
+		count = 0;
+
+		for (std::vector<float>* v : { &x, &y, &z, &radius, &axisX, &axisY, &axisZ, &cutoff, &horizonX, &horizonY, &horizonZ })
+		{
+			v->clear();
+		}
+	}
+
+	void CullBatch::Cull(const Frustum& frustum, bool eye, glm::vec3 camera, glm::vec3 occluderCenter, float occluderRadius, std::vector<unsigned int>& visible) const
+	{
+		/*
+			A chunk is thrown out if its sphere is entirely on
+			the wrong side of any of the frustum's planes, if all
+			of its triangles face away from the camera, or if
+			the planet is between it and the camera.
+
+			The horizon test works in units of the occluder's
+			radius, around its center. Once the camera is inside
+			the occluder there's no horizon to speak of.
+		*/
+		glm::vec3 scaledCamera = (camera - occluderCenter) / occluderRadius;
+		float horizonSquared = glm::dot(scaledCamera, scaledCamera) - 1.0f;
+		bool horizon = eye && horizonSquared > 0.0f;
+		bool facing = eye && cones;
+
+#ifdef CULLING_SSE
+		for (unsigned int i = 0; i < count; i += 4)
+		{
+			__m128 cx = _mm_loadu_ps(&x[i]);
+			__m128 cy = _mm_loadu_ps(&y[i]);
+			__m128 cz = _mm_loadu_ps(&z[i]);
+			__m128 r = _mm_loadu_ps(&radius[i]);
+			__m128 negR = _mm_sub_ps(_mm_setzero_ps(), r);
+
+			__m128 culled = _mm_setzero_ps();
+
+			for (int p = 0; p < 6; p++)
+			{
+				__m128 d = _mm_add_ps(
+					_mm_add_ps(_mm_mul_ps(cx, _mm_set1_ps(frustum.planes[p].x)), _mm_mul_ps(cy, _mm_set1_ps(frustum.planes[p].y))),
+					_mm_add_ps(_mm_mul_ps(cz, _mm_set1_ps(frustum.planes[p].z)), _mm_set1_ps(frustum.planes[p].w)));
+
+				culled = _mm_or_ps(culled, _mm_cmplt_ps(d, negR));
+			}
+
+			if (facing)
+			{
+				__m128 wx = _mm_sub_ps(cx, _mm_set1_ps(camera.x));
+				__m128 wy = _mm_sub_ps(cy, _mm_set1_ps(camera.y));
+				__m128 wz = _mm_sub_ps(cz, _mm_set1_ps(camera.z));
+
+				__m128 along = _mm_add_ps(_mm_add_ps(_mm_mul_ps(wx, _mm_loadu_ps(&axisX[i])), _mm_mul_ps(wy, _mm_loadu_ps(&axisY[i]))), _mm_mul_ps(wz, _mm_loadu_ps(&axisZ[i])));
+				__m128 distance = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(wx, wx), _mm_mul_ps(wy, wy)), _mm_mul_ps(wz, wz)));
+				__m128 limit = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&cutoff[i]), distance), r);
+
+				culled = _mm_or_ps(culled, _mm_cmpge_ps(along, limit));
+			}
+
+			if (horizon)
+			{
+				__m128 sx = _mm_set1_ps(scaledCamera.x);
+				__m128 sy = _mm_set1_ps(scaledCamera.y);
+				__m128 sz = _mm_set1_ps(scaledCamera.z);
+				__m128 h = _mm_set1_ps(horizonSquared);
+
+				__m128 vx = _mm_sub_ps(_mm_loadu_ps(&horizonX[i]), sx);
+				__m128 vy = _mm_sub_ps(_mm_loadu_ps(&horizonY[i]), sy);
+				__m128 vz = _mm_sub_ps(_mm_loadu_ps(&horizonZ[i]), sz);
+
+				__m128 toward = _mm_sub_ps(_mm_setzero_ps(), _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, sx), _mm_mul_ps(vy, sy)), _mm_mul_ps(vz, sz)));
+				__m128 lengthSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)), _mm_mul_ps(vz, vz));
+
+				__m128 hidden = _mm_and_ps(_mm_cmpgt_ps(toward, h), _mm_cmpgt_ps(_mm_mul_ps(toward, toward), _mm_mul_ps(h, lengthSquared)));
+				culled = _mm_or_ps(culled, hidden);
+			}
+
+			int mask = ~_mm_movemask_ps(culled) & 0xF;
+
+			for (unsigned int k = 0; k < 4 && i + k < count; k++)
+			{
+				if (mask & (1 << k)) visible.push_back(i + k);
+			}
+		}
+#else
+		for (unsigned int i = 0; i < count; i++)
+		{
+			glm::vec3 center = glm::vec3(x[i], y[i], z[i]);
+			bool culled = false;
+
+			for (int p = 0; p < 6; p++)
+			{
+				if (glm::dot(glm::vec3(frustum.planes[p].x, frustum.planes[p].y, frustum.planes[p].z), center) + frustum.planes[p].w < -radius[i]) culled = true;
+			}
+
+			if (facing)
+			{
+				glm::vec3 w = center - camera;
+				if (glm::dot(w, glm::vec3(axisX[i], axisY[i], axisZ[i])) >= cutoff[i] * glm::length(w) + radius[i]) culled = true;
+			}
+
+			if (horizon)
+			{
+				glm::vec3 v = glm::vec3(horizonX[i], horizonY[i], horizonZ[i]) - scaledCamera;
+				float toward = -glm::dot(v, scaledCamera);
+
+				if (toward > horizonSquared && toward * toward > horizonSquared * glm::dot(v, v)) culled = true;
+			}
+
+			if (!culled) visible.push_back(i);
+		}
+#endif
+	}
+}
@@ -0,0 +1,114 @@
+#ifndef CULLING_H
+#define CULLING_H
+
+/*
+	culling.h
+
+	Bounds for the chunks of the planet (and the
+	ocean) and the tests for whether the camera can
+	see any of them. None of this touches OpenGL.
+*/
+
+#include <vector>
+#include <glm/glm.hpp>
+
+namespace Mandalin
+{
+	/*-----------------------------------------------*/
+	/* Bounds */
+	/*-----------------------------------------------*/
+	struct BoundingSphere
+	{
+		glm::vec3				center;
+		float					radius;
+	};
+
+	/*
+		Every triangle in a chunk faces within some angle
+		of the cone's axis. The cutoff is the sine of that
+		angle, or anything above 1 if the triangles face
+		too many ways for the cone to ever cull the chunk.
+	*/
+	struct NormalCone
+	{
+		glm::vec3				axis;
+		float					cutoff;
+	};
+
+	BoundingSphere				BuildBoundingSphere(const std::vector<glm::vec3>& points);
+
+	// The normals should all point out of the geometry.
+	NormalCone					BuildNormalCone(glm::vec3 axis, const std::vector<glm::vec3>& normals);
+
+	/*
+		The planet itself hides everything behind it. We
+		treat it as a sphere (the largest one that fits
+		under its surface) and, for each chunk, find a
+		single point along the chunk's direction which is
+		only hidden by that sphere when every one of the
+		chunk's points is too. Once that's done, the test
+		each frame is just whether that one point is over
+		the horizon.
+
+		The point is kept relative to the occluder's center
+		and in units of its radius.
+	*/
+	glm::vec3					BuildHorizonPoint(const std::vector<glm::vec3>& points, glm::vec3 occluderCenter, float occluderRadius);
+
+	/*-----------------------------------------------*/
+	/* Frustum */
+	/*-----------------------------------------------*/
+	/*
+		The six planes of the camera's view, pulled out of
+		its view-projection matrix. Each plane's normal
+		points into the frustum.
+	*/
+	struct Frustum
+	{
+		glm::vec4				planes[6];
+
+		Frustum(const glm::mat4& viewProjection);
+	};
+
+	/*-----------------------------------------------*/
+	/* Cull Batch */
+	/*-----------------------------------------------*/
+	/*
+		The bounds of a list of chunks, kept component by
+		component (and padded out to a multiple of four)
+		so that they can be tested four at a time.
+	*/
+	class CullBatch
+	{
+	private:
+		unsigned int			count = 0;
+
+		// Whether the entries have normal cones at all.
+		bool					cones;
+
+		std::vector<float>		x, y, z, radius;
+		std::vector<float>		axisX, axisY, axisZ, cutoff;
+		std::vector<float>		horizonX, horizonY, horizonZ;
+
+	public:
+		unsigned int			Size() { return count; }
+
+		void					Add(BoundingSphere sphere, NormalCone cone, glm::vec3 horizon);
+		void					Add(BoundingSphere sphere, glm::vec3 horizon);
+		void					Clear();
+
+		/*
+			Appends the index of every entry that might be seen
+			to visible. The horizon and normal cone tests need
+			a camera at a point, so they're skipped when eye is
+			false (as with an orthographic lens). The normal
+			cone test is also skipped for a batch built without
+			cones.
+		*/
+		void					Cull(const Frustum& frustum, bool eye, glm::vec3 camera, glm::vec3 occluderCenter, float occluderRadius, std::vector<unsigned int>& visible) const;
+
+		CullBatch(bool cones = true) { this->cones = cones; }
+	};
+}
+
+#endif
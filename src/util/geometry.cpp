@@ -2,23 +2,107 @@
 
 #include <corecrt_math_defines.h>
 #include <glm/gtx/norm.hpp>
+#include <queue>
 #include <algorithm>
 #include <iostream>
-#include <unordered_map>
-#include <glm/gtx/hash.hpp>
 
 #include "settings.h"
 
 namespace Mandalin
 {
-	bool CompareDistances(HexNode a, HexNode b)
+	/*-----------------------------------------------*/
+	/* Hex Nodes */
+	/*-----------------------------------------------*/
+	void HexNodes::Resize(unsigned int nodeCount)
+	{
+		/*
+			Every node starts out with the same defaults; only
+			the centers and neighbors are left to be filled in.
+		*/
+		center.assign(nodeCount, glm::vec3(0.0f, 0.0f, 0.0f));
+		biome.assign(nodeCount, Biome::broadleafforest);
+		biomeVariation.assign(nodeCount, 0);
+		latitude.assign(nodeCount, 0.0f);
+		temperature.assign(nodeCount, 0.0f);
+		rainfall.assign(nodeCount, 0.0f);
+		flags.assign(nodeCount, 0);
+		mountainDistance.assign(nodeCount, -1);
+		region.assign(nodeCount, -1);
+		continent.assign(nodeCount, -1);
+		tectonicPlate.assign(nodeCount, -1);
+		regionDistance.assign(nodeCount, 0.0f);
+	}
+
+	template <typename T>
+	static void Gather(std::vector<T>& values, const std::vector<unsigned int>& order)
+	{
+		std::vector<T> out;
+		out.reserve(order.size());
+
+		for (int i = 0; i < order.size(); i++) out.push_back(values[order[i]]);
+
+		values.swap(out);
+	}
+
+	void HexNodes::Permute(const std::vector<unsigned int>& order)
+	{
+		/*
+			The node that ends up at i is the one that was at
+			order[i]. Every array is gathered into its new
+			place and the neighbors are renumbered to match.
+		*/
+		std::vector<unsigned int> newIndex(order.size());
+		for (int i = 0; i < order.size(); i++) newIndex[order[i]] = i;
+
+		std::vector<unsigned int> offsets;
+		std::vector<unsigned int> adjacency;
+
+		offsets.reserve(order.size() + 1);
+		adjacency.reserve(neighbors.size());
+		offsets.push_back(0);
+
+		for (int i = 0; i < order.size(); i++)
+		{
+			for (unsigned int j = neighborOffsets[order[i]]; j < neighborOffsets[order[i] + 1]; j++)
+			{
+				adjacency.push_back(newIndex[neighbors[j]]);
+			}
+
+			offsets.push_back(adjacency.size());
+		}
+
+		neighborOffsets.swap(offsets);
+		neighbors.swap(adjacency);
+
+		Gather(center, order);
+		Gather(biome, order);
+		Gather(biomeVariation, order);
+		Gather(latitude, order);
+		Gather(temperature, order);
+		Gather(rainfall, order);
+		Gather(flags, order);
+		Gather(mountainDistance, order);
+		Gather(region, order);
+		Gather(continent, order);
+		Gather(tectonicPlate, order);
+		Gather(regionDistance, order);
+	}
+
+	void HexNodes::Clear()
 	{
-		return (a.regionDistance < b.regionDistance);
+		/*
+			Assigning a fresh set of arrays actually frees the
+			memory (clear() alone would hold onto it).
+		*/
+		*this = HexNodes();
 	}
 
-	int GetVoronoiStart(int size, std::vector<int> selectedStarts)
+	/*-----------------------------------------------*/
+	/* Voronoi */
+	/*-----------------------------------------------*/
+	int GetVoronoiStart(int size, std::vector<int> selectedStarts, Random& rng)
 	{
-		int r = rand() % size;
+		int r = rng.Range(size);
 
 		bool found = false;
 
@@ -27,197 +111,290 @@ namespace Mandalin
 			if (selectedStarts[i] == r) found = true;
 		}
 
-		if (found) return GetVoronoiStart(size, selectedStarts);
+		if (found) return GetVoronoiStart(size, selectedStarts, rng);
 		return r;
 	}
 
-	std::vector<HexNode> VoronoiSort(std::vector<HexNode> unordered)
+	/*
+		A graph of regions or continents, kept the same way as
+		the hex neighbors: the neighbors of item i are those
+		from adjacency[offsets[i]] up to (but not including)
+		adjacency[offsets[i + 1]].
+	*/
+	struct LabelGraph
 	{
-		srand(time(NULL));
+		std::vector<unsigned int>	offsets;
+		std::vector<unsigned int>	adjacency;
+		std::vector<glm::vec3>		positions;
+	};
 
-		std::vector<std::vector<HexNode>> regions;
-		std::vector<std::vector<unsigned int>> continents;
-		std::vector<std::vector<unsigned int>> tectonicPlates;
+	/*
+		Grows a label outward from each seed over the graph,
+		always claiming whichever unclaimed item is closest
+		(in a straight line) to the seed reaching for it. This
+		is the nearest-seed assignment the old brute-force
+		search made, but it only ever measures the distance
+		across the edge it is looking over, so it stays
+		close to linear in the size of the graph.
+
+		Items are handed back in the order they were claimed,
+		which (per label) is nearest to farthest.
+	*/
+	static std::vector<unsigned int> GrowLabels(const std::vector<unsigned int>& offsets, const std::vector<unsigned int>& adjacency, const std::vector<glm::vec3>& positions,
+		const std::vector<unsigned int>& seeds, std::vector<int>& labels, std::vector<float>& distances)
+	{
+		typedef std::pair<float, std::pair<unsigned int, unsigned int>> Claim;		// < distance, < item, label > >
+		std::priority_queue<Claim, std::vector<Claim>, std::greater<Claim>> frontier;
 
-		std::vector<int> selectedStarts;
+		std::vector<unsigned int> claimed;
+		claimed.reserve(positions.size());
 
-		/*
-			First, we find all our regional centers.
-		*/
-		for (int i = 0; i < Settings::RegionCount; i++)
-		{
-			int r = GetVoronoiStart(unordered.size(), selectedStarts);
-			
-			unordered[r].region = i;
+		labels.assign(positions.size(), -1);
+		distances.assign(positions.size(), 0.0f);
 
-			regions.push_back({ unordered[r] });
-			selectedStarts.push_back(r);
-		}
+		for (unsigned int i = 0; i < seeds.size(); i++) frontier.push({ 0.0f, { seeds[i], i } });
 
-		/*
-			Now, we loop through all the hexes and find
-			the region closest to them.
-		*/
-		for (int i = 0; i < unordered.size(); i++)
+		while (!frontier.empty())
 		{
-			HexNode* hn = &unordered[i];
+			Claim claim = frontier.top();
+			frontier.pop();
+
+			unsigned int item = claim.second.first;
+			unsigned int label = claim.second.second;
+
+			if (labels[item] != -1) continue;
 
-			if (hn->region != -1) continue;
+			labels[item] = label;
+			distances[item] = claim.first;
+			claimed.push_back(item);
 
-			float minDist = INFINITY;
-			unsigned int minIndex = 0;
+			glm::vec3 seed = positions[seeds[label]];
 
-			for (int j = 0; j < regions.size(); j++)
+			for (unsigned int i = offsets[item]; i < offsets[item + 1]; i++)
 			{
-				float dist = glm::distance(hn->center, regions[j][0].center);
+				unsigned int neighbor = adjacency[i];
+				if (labels[neighbor] != -1) continue;
 
-				if (dist < minDist)
-				{
-					minDist = dist;
-					minIndex = j;
-				}
+				frontier.push({ glm::distance(positions[neighbor], seed), { neighbor, label } });
 			}
-
-			hn->regionDistance = minDist;
-			hn->region = minIndex;
-			regions[minIndex].push_back(*hn);
 		}
 
-		/*
-			Quickly, we're going to sort each region by each hex's
-			distance from the center point.
-		*/
-		for (int i = 0; i < regions.size(); i++) std::sort(regions[i].begin(), regions[i].end(), CompareDistances);
+		return claimed;
+	}
 
-		/*
-			Now we find all our plate centers (which are regions).
-		*/
-		selectedStarts.clear();
+	/*
+		Builds the graph of the labels themselves, where two
+		labels are neighbors if any of their items are.
+	*/
+	static LabelGraph CoarsenGraph(const std::vector<unsigned int>& offsets, const std::vector<unsigned int>& adjacency, const std::vector<glm::vec3>& positions,
+		const std::vector<int>& labels, const std::vector<unsigned int>& seeds)
+	{
+		std::vector<std::vector<unsigned int>> touching(seeds.size());
 
-		for (int i = 0; i < Settings::ContinentCount; i++)
+		for (unsigned int i = 0; i < labels.size(); i++)
 		{
-			int r = GetVoronoiStart(regions.size(), selectedStarts);
-
-			// We have to set the continent for each of the hexes within.
-			for (int j = 0; j < regions[r].size(); j++)
+			for (unsigned int j = offsets[i]; j < offsets[i + 1]; j++)
 			{
-				regions[r][j].continent = i;
+				int other = labels[adjacency[j]];
+				if (other != labels[i]) touching[labels[i]].push_back(other);
 			}
-			
-			continents.push_back({ (unsigned int)r });
-			selectedStarts.push_back(r);
 		}
 
-		/*
-			And now we go through all the regions and determine
-			which continent is closest.
-		*/
-		for (int i = 0; i < regions.size(); i++)
+		LabelGraph coarse;
+		coarse.offsets.push_back(0);
+
+		for (unsigned int i = 0; i < seeds.size(); i++)
 		{
-			if (regions[i][0].continent != -1) continue;
+			std::sort(touching[i].begin(), touching[i].end());
+			touching[i].erase(std::unique(touching[i].begin(), touching[i].end()), touching[i].end());
 
-			float minDist = INFINITY;
-			unsigned int minIndex = 0;
+			coarse.adjacency.insert(coarse.adjacency.end(), touching[i].begin(), touching[i].end());
+			coarse.offsets.push_back(coarse.adjacency.size());
 
-			for (int j = 0; j < continents.size(); j++)
-			{
-				float dist = glm::distance(regions[i][0].center, regions[continents[j][0]][0].center);
+			// Each label sits where its seed does.
+			coarse.positions.push_back(positions[seeds[i]]);
+		}
 
-				if (dist < minDist)
-				{
-					minDist = dist;
-					minIndex = j;
-				}
-			}
+		return coarse;
+	}
 
-			for (int j = 0; j < regions[i].size(); j++)
-			{
-				regions[i][j].continent = minIndex;
-			}
-			continents[minIndex].push_back(i);
+	/*
+		Splits the claim order up by label, keeping each
+		label's items in the order they were claimed.
+	*/
+	static std::vector<std::vector<unsigned int>> GroupByLabel(const std::vector<unsigned int>& claimed, const std::vector<int>& labels, unsigned int labelCount)
+	{
+		std::vector<std::vector<unsigned int>> groups(labelCount);
+		for (int i = 0; i < claimed.size(); i++) groups[labels[claimed[i]]].push_back(claimed[i]);
+		return groups;
+	}
+
+	std::vector<unsigned int> VoronoiSort(WorldGenContext& context)
+	{
+		HexNodes& nodes = context.nodes;
+		Random rng = context.seed.Stream(SeedStage::voronoi);
+
+		std::vector<int> selectedStarts;
+
+		/*
+			First, we find all our regional centers and grow the
+			regions out from them over the hexes themselves.
+		*/
+		std::vector<unsigned int> regionSeeds;
+
+		for (int i = 0; i < Settings::RegionCount; i++)
+		{
+			int r = GetVoronoiStart(nodes.Size(), selectedStarts, rng);
+
+			regionSeeds.push_back(r);
+			selectedStarts.push_back(r);
 		}
 
+		std::vector<unsigned int> hexOrder = GrowLabels(nodes.neighborOffsets, nodes.neighbors, nodes.center, regionSeeds, nodes.region, nodes.regionDistance);
+
 		/*
-			Antepenultimately, we find all the centers of our
-			tectonic plates.
+			Now we find all our continent centers (which are regions)
+			and grow them over the graph of which regions touch.
 		*/
 		selectedStarts.clear();
+		std::vector<unsigned int> continentSeeds;
 
-		for (int i = 0; i < Settings::TectonicPlateCount; i++)
+		for (int i = 0; i < Settings::ContinentCount; i++)
 		{
-			int r = GetVoronoiStart(continents.size(), selectedStarts);
+			int r = GetVoronoiStart(regionSeeds.size(), selectedStarts, rng);
 
-			// We have to set the plate for each of the hexes within.
-			for (int j = 0; j < continents[r].size(); j++)
-			{
-				for (int k = 0; k < regions[continents[r][j]].size(); k++)
-				{
-					regions[continents[r][j]][k].tectonicPlate = i;
-				}
-			}
-
-			tectonicPlates.push_back({ (unsigned int)r });
+			continentSeeds.push_back(r);
 			selectedStarts.push_back(r);
-
-			glm::vec4 color = glm::vec4((rand() % 100) / 100.0f, (rand() % 100) / 100.0f, (rand() % 100) / 100.0f, 1.0f);
-			Settings::TectonicPlateColors[i] = color;
 		}
 
+		LabelGraph regions = CoarsenGraph(nodes.neighborOffsets, nodes.neighbors, nodes.center, nodes.region, regionSeeds);
+
+		std::vector<int> regionContinents;
+		std::vector<float> regionDistances;
+		std::vector<unsigned int> regionOrder = GrowLabels(regions.offsets, regions.adjacency, regions.positions, continentSeeds, regionContinents, regionDistances);
+
 		/*
-			Penultimately, we go through each continent and sort out
-			which tectonic plate is closest.
+			And the same again for our tectonic plates (which are
+			continents) over the graph of which continents touch.
 		*/
-		for (int i = 0; i < continents.size(); i++)
+		selectedStarts.clear();
+		std::vector<unsigned int> plateSeeds;
+
+		for (int i = 0; i < Settings::TectonicPlateCount; i++)
 		{
-			if (regions[continents[i][0]][0].tectonicPlate != -1) continue;
+			int r = GetVoronoiStart(continentSeeds.size(), selectedStarts, rng);
 
-			float minDist = INFINITY;
-			unsigned int minIndex = 0;
+			plateSeeds.push_back(r);
+			selectedStarts.push_back(r);
 
-			for (int j = 0; j < tectonicPlates.size(); j++)
-			{
-				float dist = glm::distance(regions[continents[i][0]][0].center, regions[continents[tectonicPlates[j][0]][0]][0].center);
+			float red = rng.Range(100) / 100.0f;
+			float green = rng.Range(100) / 100.0f;
+			float blue = rng.Range(100) / 100.0f;
+			Settings::TectonicPlateColors[i] = glm::vec4(red, green, blue, 1.0f);
+		}
 
-				if (dist < minDist)
-				{
-					minDist = dist;
-					minIndex = j;
-				}
-			}
+		Settings::PaletteVersion++;
 
-			for (int j = 0; j < continents[i].size(); j++)
-			{
-				for (int k = 0; k < regions[continents[i][j]].size(); k++)
-				{
-					regions[continents[i][j]][k].tectonicPlate = minIndex;
-				}
-			}
+		LabelGraph continents = CoarsenGraph(regions.offsets, regions.adjacency, regions.positions, regionContinents, continentSeeds);
 
-			for (int j = 0; j < regions[i].size(); j++)
-			{
-				regions[i][j].continent = minIndex;
-			}
-			tectonicPlates[minIndex].push_back(i);
+		std::vector<int> continentPlates;
+		std::vector<float> continentDistances;
+		GrowLabels(continents.offsets, continents.adjacency, continents.positions, plateSeeds, continentPlates, continentDistances);
+
+		for (unsigned int i = 0; i < nodes.Size(); i++)
+		{
+			nodes.continent[i] = regionContinents[nodes.region[i]];
+			nodes.tectonicPlate[i] = continentPlates[nodes.continent[i]];
 		}
 
 		/*
 			Now, we go through and sort all our nodes by continent
-			and then by region.
+			and then by region (and within a region, from the center
+			outward). We only hand back the new order (order[new] =
+			old), which the caller then applies to all the node
+			arrays in one go.
 		*/
-		std::vector<HexNode> out;
+		std::vector<std::vector<unsigned int>> continentRegions = GroupByLabel(regionOrder, regionContinents, continentSeeds.size());
+		std::vector<std::vector<unsigned int>> regionHexes = GroupByLabel(hexOrder, nodes.region, regionSeeds.size());
+
+		std::vector<unsigned int> order;
+		order.reserve(nodes.Size());
 
-		for (int i = 0; i < continents.size(); i++)
+		for (int i = 0; i < continentRegions.size(); i++)
 		{
-			for (int j = 0; j < continents[i].size(); j++)
+			for (int j = 0; j < continentRegions[i].size(); j++)
 			{
-				for (int k = 0; k < regions[continents[i][j]].size(); k++)
-				{
-					out.push_back(regions[continents[i][j]][k]);
-				}
+				std::vector<unsigned int>* hexes = &regionHexes[continentRegions[i][j]];
+				order.insert(order.end(), hexes->begin(), hexes->end());
 			}
 		}
 
-		return out;
+		return order;
+	}
+
+	/*-----------------------------------------------*/
+	/* Chunk Bisection */
+	/*-----------------------------------------------*/
+	/*
+		Splits the slots from begin to end (slots in the Voronoi
+		order) in two across whichever axis their hexes spread
+		out along the most. The first half gets room for exactly
+		half the chunks (rounded up), so every chunk but the very
+		last comes out full.
+	*/
+	static void Bisect(const HexNodes& nodes, const std::vector<unsigned int>& order, unsigned int* begin, unsigned int* end, unsigned int chunkSize)
+	{
+		unsigned int count = end - begin;
+		unsigned int chunkCount = (count + chunkSize - 1) / chunkSize;
+
+		if (chunkCount <= 1)
+		{
+			// Within a chunk, we keep to the Voronoi order, so a
+			// chunk's hexes are still grouped by region.
+			std::sort(begin, end);
+			return;
+		}
+
+		glm::vec3 low = nodes.center[order[*begin]];
+		glm::vec3 high = low;
+
+		for (unsigned int* i = begin; i < end; i++)
+		{
+			low = glm::min(low, nodes.center[order[*i]]);
+			high = glm::max(high, nodes.center[order[*i]]);
+		}
+
+		glm::vec3 extent = high - low;
+		int axis = 0;
+		if (extent.y > extent[axis]) axis = 1;
+		if (extent.z > extent[axis]) axis = 2;
+
+		unsigned int* middle = begin + chunkSize * ((chunkCount + 1) / 2);
+
+		// Ties are broken by slot so the split never depends on
+		// how the standard library happens to shuffle things.
+		std::nth_element(begin, middle, end, [&](unsigned int a, unsigned int b)
+			{
+				float pa = nodes.center[order[a]][axis];
+				float pb = nodes.center[order[b]][axis];
+				return pa < pb || (pa == pb && a < b);
+			});
+
+		Bisect(nodes, order, begin, middle, chunkSize);
+		Bisect(nodes, order, middle, end, chunkSize);
+	}
+
+	std::vector<unsigned int> ChunkSort(const HexNodes& nodes, const std::vector<unsigned int>& order, unsigned int chunkSize)
+	{
+		std::vector<unsigned int> slots(order.size());
+		for (unsigned int i = 0; i < slots.size(); i++) slots[i] = i;
+
+		if (!slots.empty()) Bisect(nodes, order, &slots[0], &slots[0] + slots.size(), chunkSize);
+
+		std::vector<unsigned int> chunked(order.size());
+		for (unsigned int i = 0; i < slots.size(); i++) chunked[i] = order[slots[i]];
+
+		return chunked;
 	}
 
 	/*std::vector<HexNode> VoronoiSort(std::vector<HexNode> unordered, int desiredCount)
@@ -281,167 +458,133 @@ namespace Mandalin
 		return out;
 	}*/
 
-	struct Vec3Hash
+	unsigned int Polyhedron::Valence(unsigned int v) const
 	{
-		size_t operator()(const glm::vec3& v) const
+		unsigned int count = 0;
+		unsigned int e = vertices[v].edge;
+
+		do
 		{
-			return std::hash<glm::vec3>()(v);
-		}
-	};
+			count++;
+			e = NextAround(e);
+		} while (e != vertices[v].edge);
 
-	void Polyhedron::Subdivide()
+		return count;
+	}
+
+	void Polyhedron::Subdivide(WorkerPool& workers)
 	{
-		int added = 0;
-		std::vector<TriFace> out;
-		// out.reserve(faces.size() * 4);
+		/*
+			Each triangle is split into four by the midpoints of
+			its edges:
+
+					  c
+					 / \
+				   ca---bc
+				   / \ / \
+				  a---ab---b
+
+			On a closed mesh every edge has exactly two faces, so
+			the counts for the next level are known up front:
+			every old vertex stays, every edge adds one vertex,
+			and every face becomes four.
+		*/
+		unsigned int vertexCount = vertices.size();
+		unsigned int faceCount = faces.size();
+		unsigned int edgeCount = (3 * faceCount) / 2;
 
-		std::unordered_map<glm::vec3, unsigned int, Vec3Hash> vertexMap;
+		/*--------------------------------------------*/
+		/* Find Midpoint Indices                      */
+		/*--------------------------------------------*/
+		/*
+			An edge belongs to whichever of its two directed
+			edges comes first, so new vertices are numbered in
+			the order their edges are first seen (the same as
+			before, which keeps a given seed's world the same).
+			The twins tell us which that is without having to
+			look the edge up anywhere.
+		*/
+		std::vector<unsigned int> midpoints(3 * faceCount);
+		unsigned int added = 0;
 
-		for (int i = 0; i < vertices.size(); i++)
+		for (unsigned int e = 0; e < 3 * faceCount; e++)
 		{
-			vertices[i].sharers.clear();
+			if (e < twins[e]) midpoints[e] = vertexCount + added++;
+			else midpoints[e] = midpoints[twins[e]];
 		}
 
-		for (int i = 0; i < faces.size(); i++)
+		std::vector<TriFace> out(4 * faceCount);
+		std::vector<unsigned int> outTwins(12 * faceCount);
+		vertices.resize(vertexCount + edgeCount);
+
+		/*--------------------------------------------*/
+		/* New Vertices, Triangles & Twins            */
+		/*--------------------------------------------*/
+		/*
+			Each old edge is split in two. The first half still
+			starts at the old corner and the second half starts
+			at the midpoint. Going by the layout above:
+
+				ab: ta.0 (a -> ab)		tb.0 (ab -> b)
+				bc: tb.1 (b -> bc)		tc.1 (bc -> c)
+				ca: tc.2 (c -> ca)		ta.2 (ca -> a)
+
+			The first half of an edge is the twin of the second
+			half of its old twin, and the other way around. The
+			three edges inside the old face pair up with td.
+
+			A midpoint is only written by the face owning its
+			edge so no two threads ever touch the same vertex.
+		*/
+		auto firstHalf = [](unsigned int e) { return 3 * (4 * (e / 3) + e % 3) + e % 3; };
+		auto secondHalf = [](unsigned int e) { return 3 * (4 * (e / 3) + (e + 1) % 3) + e % 3; };
+
+		workers.ParallelFor(faceCount, [&](unsigned int i)
 		{
-			/*--------------------------------------------*/
-			/* Old Vertices                               */
-			/*--------------------------------------------*/
-			/*
-				First, we grab the indices of the
-				old vertices which aren't going to
-				change.
-			*/
-			unsigned int aI = faces[i].a;
-			unsigned int bI = faces[i].b;
-			unsigned int cI = faces[i].c;
-
-			/*
-				Then, we grab the vertices which also
-				aren't going to change. However, the
-				triangles to which they belong are
-				going to change (sadly).
-			*/
-			PolyVert* a = &vertices[aI];
-			PolyVert* b = &vertices[bI];
-			PolyVert* c = &vertices[cI];
-
-			/*--------------------------------------------*/
-			/* New Vertices                               */
-			/*--------------------------------------------*/
-			/*
-				We need to find out where each new
-				vertex will be.
-			*/
-			unsigned int abI = 0;
-			unsigned int bcI = 0;
-			unsigned int caI = 0;
-
-			PolyVert midAB = { radius * glm::normalize((a->vertex + b->vertex) / 2.0f), {} };
-			PolyVert midBC = { radius * glm::normalize((b->vertex + c->vertex) / 2.0f), {} };
-			PolyVert midCA = { radius * glm::normalize((c->vertex + a->vertex) / 2.0f), {} };
-
-			/*--------------------------------------------*/
-			/* Find Midpoint Indices                      */
-			/*--------------------------------------------*/
-			bool foundAB = false;
-			bool foundBC = false;
-			bool foundCA = false;
-
-			auto itAB = vertexMap.find(midAB.vertex);
-			if (itAB == vertexMap.end())
-			{
-				abI = vertices.size();
-				vertexMap[midAB.vertex] = abI;
-				vertices.push_back(midAB);
-			}
-			else
-			{
-				foundAB = true;
-				abI = itAB->second;
-			}
+			unsigned int corners[3] = { faces[i].a, faces[i].b, faces[i].c };
+			unsigned int mids[3] = { midpoints[3 * i], midpoints[3 * i + 1], midpoints[3 * i + 2] };
 
-			auto itBC = vertexMap.find(midBC.vertex);
-			if (itBC == vertexMap.end())
-			{
-				bcI = vertices.size();
-				vertexMap[midBC.vertex] = bcI;
-				vertices.push_back(midBC);
-			}
-			else
+			for (unsigned int k = 0; k < 3; k++)
 			{
-				foundBC = true;
-				bcI = itBC->second;
-			}
+				unsigned int e = 3 * i + k;
+				unsigned int t = twins[e];
 
-			auto itCA = vertexMap.find(midCA.vertex);
-			if (itCA == vertexMap.end())
-			{
-				caI = vertices.size();
-				vertexMap[midCA.vertex] = caI;
-				vertices.push_back(midCA);
-			}
-			else
-			{
-				foundCA = true;
-				caI = itCA->second;
+				outTwins[firstHalf(e)] = secondHalf(t);
+				outTwins[secondHalf(e)] = firstHalf(t);
+
+				if (e < t)
+				{
+					glm::vec3 u = vertices[corners[k]].vertex;
+					glm::vec3 v = vertices[corners[(k + 1) % 3]].vertex;
+
+					vertices[mids[k]].vertex = radius * glm::normalize((u + v) / 2.0f);
+					vertices[mids[k]].edge = secondHalf(e);
+				}
 			}
 
-			/*--------------------------------------------*/
-			/* Finding Triangles                          */
-			/*--------------------------------------------*/
-			/*
-				My brain is a little scattered today
-				bear with me.
-			*/
-			/*out[added] = { aI, abI, caI };
-			out[static_cast<std::vector<Mandalin::TriFace, std::allocator<Mandalin::TriFace>>::size_type>(added) + 1] = { abI, bI, bcI };
-			out[static_cast<std::vector<Mandalin::TriFace, std::allocator<Mandalin::TriFace>>::size_type>(added) + 2] = { caI, bcI, cI };
-			out[static_cast<std::vector<Mandalin::TriFace, std::allocator<Mandalin::TriFace>>::size_type>(added) + 3] = { abI, bcI, caI };*/
-
-			out.push_back({ aI, abI, caI });
-			out.push_back({ abI, bI, bcI });
-			out.push_back({ caI, bcI, cI });
-			out.push_back({ abI, bcI, caI });
-
-			// You could fit my brain in a thimble.
-			unsigned int taI = added;
-			unsigned int tbI = added + 1;
-			unsigned int tcI = added + 2;
-			unsigned int tdI = added + 3;
-			added += 4;
-
-			TriFace* ta = &out[taI];
-			TriFace* tb = &out[tbI];
-			TriFace* tc = &out[tcI];
-			TriFace* td = &out[tdI];
-
-			/*
-				First we're going to add these triangles to
-				the vertices we already have indices for.
-			*/
-			vertices[aI].sharers.push_back(taI);
-			vertices[bI].sharers.push_back(tbI);
-			vertices[cI].sharers.push_back(tcI);
-
-			/*
-				Now we go through and find all the indices
-				for the vertices we just added.
-			*/
-			vertices[abI].sharers.push_back(taI);
-			vertices[abI].sharers.push_back(tbI);
-			vertices[abI].sharers.push_back(tdI);
-			vertices[bcI].sharers.push_back(tbI);
-			vertices[bcI].sharers.push_back(tcI);
-			vertices[bcI].sharers.push_back(tdI);
-			vertices[caI].sharers.push_back(tcI);
-			vertices[caI].sharers.push_back(tdI);
-			vertices[caI].sharers.push_back(taI);
-		}
+			out[4 * i] = { corners[0], mids[0], mids[2] };
+			out[4 * i + 1] = { mids[0], corners[1], mids[1] };
+			out[4 * i + 2] = { mids[2], mids[1], corners[2] };
+			out[4 * i + 3] = { mids[0], mids[1], mids[2] };
+
+			unsigned int ta = 12 * i, tb = ta + 3, tc = ta + 6, td = ta + 9;
+
+			outTwins[ta + 1] = td + 2;	outTwins[td + 2] = ta + 1;
+			outTwins[tb + 2] = td;		outTwins[td] = tb + 2;
+			outTwins[tc] = td + 1;		outTwins[td + 1] = tc;
+		});
 
-		faces.clear();	// I don't think this is strictly necessary.
-						// But also, what the heck.
-		for (int i = 0; i < added; i++) faces.push_back(out[i]);
+		/*
+			An old vertex's edge is the first half of the
+			edge it had.
+		*/
+		workers.ParallelFor(vertexCount, [&](unsigned int i)
+		{
+			vertices[i].edge = firstHalf(vertices[i].edge);
+		});
+
+		faces.swap(out);
+		twins.swap(outTwins);
 	}
 
 	Polyhedron::Polyhedron(int worldSize)
@@ -458,9 +601,9 @@ namespace Mandalin
 
 		vertices =
 		{
-			{ { -x, n, z }, {} }, { { x, n, z }, {} }, { { -x, n, -z }, {} }, { { x, n, -z }, {} },
-			{ { n, z, x }, {} }, { { n, z, -x }, {} }, { { n, -z, x }, {} }, { { n, -z, -x }, {} },
-			{ { z, x, n }, {} }, { { -z, x, n }, {} }, { { z, -x, n }, {} }, { { -z, -x, n }, {} }
+			{ { -x, n, z }, 0 }, { { x, n, z }, 0 }, { { -x, n, -z }, 0 }, { { x, n, -z }, 0 },
+			{ { n, z, x }, 0 }, { { n, z, -x }, 0 }, { { n, -z, x }, 0 }, { { n, -z, -x }, 0 },
+			{ { z, x, n }, 0 }, { { -z, x, n }, 0 }, { { z, -x, n }, 0 }, { { -z, -x, n }, 0 }
 		};
 
 		faces =
@@ -474,11 +617,25 @@ namespace Mandalin
 		for (int i = 0; i < vertices.size(); i++)
 		{
 			vertices[i].vertex = radius * glm::normalize(vertices[i].vertex);
+		}
+
+		/*
+			Subdivide keeps the twins up to date from here on,
+			we just have to find them once for the icosahedron.
+		*/
+		twins.resize(3 * faces.size());
+
+		for (unsigned int e = 0; e < twins.size(); e++)
+		{
+			unsigned int from = EdgeOrigin(e);
+			unsigned int to = EdgeOrigin(NextEdge(e));
+
+			vertices[from].edge = e;
 
-			// I know. I don't care.
-			for (int j = 0; j < faces.size(); j++)
+			// I know. I still don't care.
+			for (unsigned int t = 0; t < twins.size(); t++)
 			{
-				if (faces[j].a == i || faces[j].b == i || faces[j].c == i) vertices[i].sharers.push_back(j);
+				if (EdgeOrigin(t) == to && EdgeOrigin(NextEdge(t)) == from) twins[e] = t;
 			}
 		}
 	}
@@ -11,6 +11,8 @@
 #include <vector>
 #include <glm/glm.hpp>
 
+#include "random.h"
+#include "workerpool.h"
 #include "../world/hex.h"
 
 namespace Mandalin
@@ -19,13 +21,15 @@ namespace Mandalin
 	/* Polyhedron Vertex */
 	/*-----------------------------------------------*/
 	/*
-		Contains a unique vertex and the
-		indices of the triangles which share it.
+		Contains a unique vertex and one of the
+		directed edges leaving it. The rest of the
+		edges (and the triangles around it) are
+		found by walking the twins from there.
 	*/
 	struct PolyVert
 	{
-		glm::vec3					vertex;
-		std::vector<unsigned int>	sharers;
+		glm::vec3				vertex;
+		unsigned int			edge;
 	};
 
 	/*-----------------------------------------------*/
@@ -45,55 +49,143 @@ namespace Mandalin
 	/*-----------------------------------------------*/
 	/* Polyhedron */
 	/*-----------------------------------------------*/
+	/*
+		Every face has three directed edges which
+		follow its winding, so edge e runs from
+		corner e % 3 of face e / 3 to the next
+		corner. The face, next and previous edges
+		are then just arithmetic, and all we have
+		to store is the twin of each edge (the
+		same edge running the other way in the
+		neighboring face).
+	*/
 	struct Polyhedron
 	{
 		std::vector<PolyVert>	vertices;
 		std::vector<TriFace>	faces;
+		std::vector<unsigned int>	twins;
 
 		float					radius = 100.0f;
 
-		void					Subdivide();
+		static unsigned int		EdgeFace(unsigned int e) { return e / 3; }
+		static unsigned int		NextEdge(unsigned int e) { return e - e % 3 + (e + 1) % 3; }
+		static unsigned int		PrevEdge(unsigned int e) { return e - e % 3 + (e + 2) % 3; }
+		unsigned int			EdgeOrigin(unsigned int e) const
+		{
+			const TriFace& f = faces[e / 3];
+			return (e % 3 == 0) ? f.a : ((e % 3 == 1) ? f.b : f.c);
+		}
+		/*
+			Steps to the next edge leaving the same vertex,
+			turning the same way the faces are wound.
+		*/
+		unsigned int			NextAround(unsigned int e) const { return twins[PrevEdge(e)]; }
+		unsigned int			Valence(unsigned int v) const;
+
+		void					Subdivide(WorkerPool& workers);
 		Polyhedron(int worldSize);
 	};
 
 	/*-----------------------------------------------*/
-	/* Hex Node (for World Generation) */
+	/* Hex Nodes (for World Generation) */
 	/*-----------------------------------------------*/
-	struct HexNode
+	/*
+		All the yes-or-no properties of a node, packed
+		into a single byte.
+	*/
+	enum class NodeFlag : unsigned char
+	{
+		fault			= 1 << 0,
+		faultNeighbor	= 1 << 1,
+		ocean			= 1 << 2,
+		oceanNeighbor	= 1 << 3,
+		rivers			= 1 << 4,
+		island			= 1 << 5
+	};
+
+	/*
+		Every property of the nodes gets its own array
+		(indexed by node), so a pass that only cares about
+		rainfall only ever walks over rainfall.
+
+		The neighbors of every node are kept in one array:
+		node i's are those from neighborOffsets[i] up to
+		(but not including) neighborOffsets[i + 1]. The
+		twelve pentagons simply have five instead of six.
+	*/
+	struct HexNodes
 	{
-		unsigned int				index;
-		glm::vec3					center;
+		std::vector<glm::vec3>		center;
+
+		std::vector<Biome>			biome;
+		std::vector<unsigned int>	biomeVariation;
+
+		std::vector<float>			latitude;
+		std::vector<float>			temperature;
+		std::vector<float>			rainfall;
+
+		std::vector<unsigned char>	flags;
+		std::vector<int>			mountainDistance;
+
+		std::vector<int>			region;
+		std::vector<int>			continent;
+		std::vector<int>			tectonicPlate;
+		std::vector<float>			regionDistance;
+
+		std::vector<unsigned int>	neighborOffsets;
 		std::vector<unsigned int>	neighbors;
 
-		Biome						biome = Biome::broadleafforest;
-		unsigned int				biomeVariation = 0;
+		unsigned int				Size() const { return center.size(); }
+		unsigned int				NeighborCount(unsigned int i) const { return neighborOffsets[i + 1] - neighborOffsets[i]; }
+		unsigned int				Neighbor(unsigned int i, unsigned int j) const { return neighbors[neighborOffsets[i] + j]; }
+		unsigned int*				Neighbors(unsigned int i) { return &neighbors[neighborOffsets[i]]; }
 
-		float						latitude = 0.0f;
-		float						temperature = 0.0f;
-		float						rainfall = 0.0f;
+		bool						Has(unsigned int i, NodeFlag flag) const { return (flags[i] & (unsigned char)flag) != 0; }
+		void						Set(unsigned int i, NodeFlag flag, bool value = true)
+		{
+			if (value) flags[i] |= (unsigned char)flag;
+			else flags[i] &= ~(unsigned char)flag;
+		}
 
-		bool						fault = false;
-		bool						faultNeighbor = false;
-		bool						ocean = false;
-		bool						oceanNeighbor = false;
+		void						Resize(unsigned int nodeCount);
+		void						Permute(const std::vector<unsigned int>& order);
+		void						Clear();
+	};
 
-		bool						rivers = false;
-		int							mountainDistance = -1;
+	/*-----------------------------------------------*/
+	/* World Generation Context */
+	/*-----------------------------------------------*/
+	/*
+		Holds the nodes for the whole of world generation.
+		Each stage works on them in place rather than being
+		handed a copy of the world and handing one back.
+	*/
+	struct WorldGenContext
+	{
+		HexNodes					nodes;
 
-		bool						island = false;
+		WorldSeed					seed;
+		glm::vec3					planetPosition;
+		float						planetRadius;
 
-		int							region = -1;
-		int							continent = -1;
-		int							tectonicPlate = -1;
-		float						regionDistance = 0.0f;
-		
-		unsigned int				tris = 0;
+		// For the stages that work on each hex on its own.
+		WorkerPool					workers;
+
+		WorldGenContext(WorldSeed seed, glm::vec3 planetPosition, float planetRadius, unsigned int threadCount)
+			: seed(seed), planetPosition(planetPosition), planetRadius(planetRadius), workers(threadCount) {}
 	};
 
-	bool CompareDistances(HexNode a, HexNode b);
+	int GetVoronoiStart(int size, std::vector<int> selectedStarts, Random& rng);
+	std::vector<unsigned int> VoronoiSort(WorldGenContext& context);
 
-	int GetVoronoiStart(int size, std::vector<int> selectedStarts);
-	std::vector<HexNode> VoronoiSort(std::vector<HexNode> unordered);
+	/*
+		Reorders the nodes (given in their Voronoi order) so
+		that each run of chunkSize of them is a compact patch
+		of the planet, by cutting the planet in half again and
+		again until each piece is a single chunk. Hands back
+		the new order the same way VoronoiSort does.
+	*/
+	std::vector<unsigned int> ChunkSort(const HexNodes& nodes, const std::vector<unsigned int>& order, unsigned int chunkSize);
 
 	/*-----------------------------------------------*/
 	/* Basic Collisions */
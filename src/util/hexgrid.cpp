@@ -0,0 +1,450 @@
+#include "hexgrid.h"
+
+#include <algorithm>
+#include <iostream>
+
+namespace Mandalin
+{
+	/*-----------------------------------------------*/
+	/* Grid Triangles */
+	/*-----------------------------------------------*/
+	/*
+		A triangle somewhere down the subdivision of one of
+		the icosahedron's faces, with the positions and the
+		coordinates of its corners. Splitting it exactly the
+		way Subdivide does gives back the very same floats,
+		so we can find any hex's center by only following
+		the triangles it sits in.
+	*/
+	struct GridTriangle
+	{
+		glm::vec3				p[3];
+		int						i[3];
+		int						j[3];
+	};
+
+	static void Midpoints(const GridTriangle& t, float radius, glm::vec3 mids[3])
+	{
+		mids[0] = radius * glm::normalize((t.p[0] + t.p[1]) / 2.0f);
+		mids[1] = radius * glm::normalize((t.p[1] + t.p[2]) / 2.0f);
+		mids[2] = radius * glm::normalize((t.p[2] + t.p[0]) / 2.0f);
+	}
+
+	/*
+		The children are numbered the same as in Subdivide:
+		ta = (a, ab, ca), tb = (ab, b, bc), tc = (ca, bc, c)
+		and td = (ab, bc, ca).
+	*/
+	static GridTriangle Child(const GridTriangle& t, const glm::vec3 mids[3], int child)
+	{
+		static const int corners[4][3] =
+		{
+			{ 0, 3, 5 }, { 3, 1, 4 }, { 5, 4, 2 }, { 3, 4, 5 }
+		};
+
+		glm::vec3 p[6] = { t.p[0], t.p[1], t.p[2], mids[0], mids[1], mids[2] };
+		int i[6] = { t.i[0], t.i[1], t.i[2], (t.i[0] + t.i[1]) / 2, (t.i[1] + t.i[2]) / 2, (t.i[2] + t.i[0]) / 2 };
+		int j[6] = { t.j[0], t.j[1], t.j[2], (t.j[0] + t.j[1]) / 2, (t.j[1] + t.j[2]) / 2, (t.j[2] + t.j[0]) / 2 };
+
+		GridTriangle out;
+
+		for (int k = 0; k < 3; k++)
+		{
+			out.p[k] = p[corners[child][k]];
+			out.i[k] = i[corners[child][k]];
+			out.j[k] = j[corners[child][k]];
+		}
+
+		return out;
+	}
+
+	static int Area(int ui, int uj, int vi, int vj, int wi, int wj)
+	{
+		return (vi - ui) * (wj - uj) - (vj - uj) * (wi - ui);
+	}
+
+	static float Side(glm::vec3 u, glm::vec3 v, glm::vec3 x)
+	{
+		return glm::dot(x, glm::cross(u, v));
+	}
+
+	/*-----------------------------------------------*/
+	/* Coordinates */
+	/*-----------------------------------------------*/
+	/*
+		It's easier to move between faces with a weight for
+		each corner of the face instead of i and j. The three
+		always add up to the resolution.
+	*/
+	static void Weights(HexCoord coord, int resolution, int weights[3])
+	{
+		weights[0] = resolution - coord.i - coord.j;
+		weights[1] = coord.i;
+		weights[2] = coord.j;
+	}
+
+	unsigned int HexGrid::Slot(HexCoord coord) const
+	{
+		return coord.face * slotsPerFace + rowStarts[coord.j] + (coord.i - coord.j % 3) / 3;
+	}
+
+	/*
+		Moves a coordinate over the given edge of a face and
+		into the face on the other side. If we unfold the two
+		faces flat, the far corner of the other face is the
+		two shared corners minus our far corner, which is all
+		we need to swap one set of weights for the other.
+	*/
+	HexCoord HexGrid::Across(unsigned int face, unsigned int edge, int weights[3]) const
+	{
+		unsigned int twin = icosahedron.twins[3 * face + edge];
+		unsigned int other = Polyhedron::EdgeFace(twin);
+		unsigned int m = twin % 3;
+
+		int far = weights[(edge + 2) % 3];
+		int moved[3];
+
+		moved[m] = weights[(edge + 1) % 3] + far;
+		moved[(m + 1) % 3] = weights[edge] + far;
+		moved[(m + 2) % 3] = -far;
+
+		return { other, moved[1], moved[2] };
+	}
+
+	/*
+		Takes weights which might have fallen off the face
+		(one of them gone negative) and puts them back on
+		whichever face they fell onto. Neighbors are never
+		far enough away to fall off two edges at once.
+	*/
+	HexCoord HexGrid::Wrap(unsigned int face, int weights[3]) const
+	{
+		for (unsigned int k = 0; k < 3; k++)
+		{
+			if (weights[(k + 2) % 3] < 0) return Across(face, k, weights);
+		}
+
+		return { face, weights[1], weights[2] };
+	}
+
+	bool HexGrid::IsPentagon(HexCoord coord) const
+	{
+		int weights[3];
+		Weights(coord, resolution, weights);
+
+		return weights[0] == resolution || weights[1] == resolution || weights[2] == resolution;
+	}
+
+	HexCoord HexGrid::Canonical(HexCoord coord) const
+	{
+		/*
+			Of all the coordinates a hex has, we go with the
+			one on the lowest numbered face.
+		*/
+		int weights[3];
+		Weights(coord, resolution, weights);
+
+		for (unsigned int k = 0; k < 3; k++)
+		{
+			if (weights[k] == resolution)
+			{
+				// One of the icosahedron's corners, so check
+				// every face around it.
+				unsigned int start = 3 * coord.face + k;
+				unsigned int best = start;
+
+				for (unsigned int e = icosahedron.NextAround(start); e != start; e = icosahedron.NextAround(e))
+				{
+					if (Polyhedron::EdgeFace(e) < Polyhedron::EdgeFace(best)) best = e;
+				}
+
+				int moved[3] = { 0, 0, 0 };
+				moved[best % 3] = resolution;
+
+				return { Polyhedron::EdgeFace(best), moved[1], moved[2] };
+			}
+		}
+
+		for (unsigned int k = 0; k < 3; k++)
+		{
+			if (weights[k] == 0)
+			{
+				// On the edge across from corner k.
+				HexCoord other = Across(coord.face, (k + 1) % 3, weights);
+				return (other.face < coord.face) ? other : coord;
+			}
+		}
+
+		return coord;
+	}
+
+	glm::vec3 HexGrid::Center(HexCoord coord) const
+	{
+		/*
+			We follow the hex down through the subdivision,
+			picking whichever child triangle it sits in, until
+			we reach the level the hexes were made at. By then
+			it's either one of the corners or the middle.
+		*/
+		const TriFace& tf = icosahedron.faces[coord.face];
+		GridTriangle t =
+		{
+			{ icosahedron.vertices[tf.a].vertex, icosahedron.vertices[tf.b].vertex, icosahedron.vertices[tf.c].vertex },
+			{ 0, resolution, 0 },
+			{ 0, 0, resolution }
+		};
+
+		for (unsigned int level = 0; level < worldSize; level++)
+		{
+			int area = Area(t.i[0], t.j[0], t.i[1], t.j[1], t.i[2], t.j[2]);
+			int wa = Area(coord.i, coord.j, t.i[1], t.j[1], t.i[2], t.j[2]);
+			int wb = Area(t.i[0], t.j[0], coord.i, coord.j, t.i[2], t.j[2]);
+			int wc = Area(t.i[0], t.j[0], t.i[1], t.j[1], coord.i, coord.j);
+
+			if (area < 0)
+			{
+				area = -area;
+				wa = -wa;
+				wb = -wb;
+				wc = -wc;
+			}
+
+			int child = 3;
+			if (2 * wa >= area) child = 0;
+			else if (2 * wb >= area) child = 1;
+			else if (2 * wc >= area) child = 2;
+
+			glm::vec3 mids[3];
+			Midpoints(t, icosahedron.radius, mids);
+			t = Child(t, mids, child);
+		}
+
+		for (int k = 0; k < 3; k++)
+		{
+			if (t.i[k] == coord.i && t.j[k] == coord.j) return t.p[k];
+		}
+
+		// Summed the same way Hexify does it.
+		glm::vec3 center = t.p[0];
+		center += t.p[1];
+		center += t.p[2];
+		return icosahedron.radius * glm::normalize(center / 3.0f);
+	}
+
+	unsigned int HexGrid::Neighbors(HexCoord coord, HexCoord* out) const
+	{
+		int weights[3];
+		Weights(coord, resolution, weights);
+
+		unsigned int count = 0;
+
+		for (unsigned int k = 0; k < 3; k++)
+		{
+			if (weights[k] != resolution) continue;
+
+			/*
+				The pentagons sit on the icosahedron's corners,
+				and their neighbors are the face hexes nearest
+				that corner on each of the five faces around it.
+			*/
+			unsigned int start = 3 * coord.face + k;
+			unsigned int e = start;
+
+			do
+			{
+				int moved[3] = { 1, 1, 1 };
+				moved[e % 3] = resolution - 2;
+
+				out[count++] = { Polyhedron::EdgeFace(e), moved[1], moved[2] };
+				e = icosahedron.NextAround(e);
+			} while (e != start);
+		}
+
+		if (count == 0)
+		{
+			/*
+				Everything else is a hex on a flat triangular
+				grid, with its six neighbors at these steps in
+				(i, j). They're listed going around the way the
+				faces are wound.
+			*/
+			static const int steps[6][2] =
+			{
+				{ 2, -1 }, { 1, 1 }, { -1, 2 }, { -2, 1 }, { -1, -1 }, { 1, -2 }
+			};
+
+			for (int n = 0; n < 6; n++)
+			{
+				int moved[3] =
+				{
+					weights[0] - steps[n][0] - steps[n][1],
+					weights[1] + steps[n][0],
+					weights[2] + steps[n][1]
+				};
+
+				out[count++] = Wrap(coord.face, moved);
+			}
+		}
+
+		if (clockwise) std::reverse(out, out + count);
+
+		return count;
+	}
+
+	HexCoord HexGrid::Locate(glm::vec3 direction) const
+	{
+		direction = glm::normalize(direction);
+
+		/*
+			The icosahedron's faces are all the same distance
+			from its center, so whichever faces the direction
+			the most is the one it passes through.
+		*/
+		unsigned int face = 0;
+		float best = -2.0f;
+
+		for (unsigned int f = 0; f < icosahedron.faces.size(); f++)
+		{
+			const TriFace& tf = icosahedron.faces[f];
+			glm::vec3 middle = icosahedron.vertices[tf.a].vertex + icosahedron.vertices[tf.b].vertex + icosahedron.vertices[tf.c].vertex;
+
+			float d = glm::dot(direction, glm::normalize(middle));
+			if (d > best)
+			{
+				best = d;
+				face = f;
+			}
+		}
+
+		const TriFace& tf = icosahedron.faces[face];
+		GridTriangle t =
+		{
+			{ icosahedron.vertices[tf.a].vertex, icosahedron.vertices[tf.b].vertex, icosahedron.vertices[tf.c].vertex },
+			{ 0, resolution, 0 },
+			{ 0, 0, resolution }
+		};
+
+		/*
+			Same as finding a center, except here we decide
+			which child we're in by which side of its inner
+			edge we're on. Every edge is a great circle, so
+			that's just a plane through the planet's center.
+		*/
+		for (unsigned int level = 0; level < worldSize; level++)
+		{
+			glm::vec3 mids[3];
+			Midpoints(t, icosahedron.radius, mids);
+
+			int child = 3;
+			if (Side(mids[0], mids[2], direction) * Side(mids[0], mids[2], t.p[0]) > 0.0f) child = 0;
+			else if (Side(mids[1], mids[0], direction) * Side(mids[1], mids[0], t.p[1]) > 0.0f) child = 1;
+			else if (Side(mids[2], mids[1], direction) * Side(mids[2], mids[1], t.p[2]) > 0.0f) child = 2;
+
+			t = Child(t, mids, child);
+		}
+
+		/*
+			The nearest hex to any point in one of the final
+			triangles is either one of its corners or the hex
+			made from the triangle itself.
+		*/
+		glm::vec3 center = t.p[0];
+		center += t.p[1];
+		center += t.p[2];
+
+		HexCoord nearest = { face, (t.i[0] + t.i[1] + t.i[2]) / 3, (t.j[0] + t.j[1] + t.j[2]) / 3 };
+		best = glm::dot(direction, glm::normalize(center));
+
+		for (int k = 0; k < 3; k++)
+		{
+			float d = glm::dot(direction, glm::normalize(t.p[k]));
+			if (d > best)
+			{
+				best = d;
+				nearest = { face, t.i[k], t.j[k] };
+			}
+		}
+
+		return Canonical(nearest);
+	}
+
+	/*-----------------------------------------------*/
+	/* Storage Ids */
+	/*-----------------------------------------------*/
+	unsigned int HexGrid::Id(HexCoord coord) const
+	{
+		return ids[Slot(Canonical(coord))];
+	}
+
+	void HexGrid::Index(const HexNodes& nodes, WorkerPool& workers)
+	{
+		std::fill(ids.begin(), ids.end(), NoHex);
+
+		workers.ParallelFor(nodes.Size(), [&](unsigned int i)
+		{
+			ids[Slot(Locate(nodes.center[i]))] = i;
+		});
+
+#ifndef NDEBUG
+		/*
+			Every node should have come back to its own slot,
+			and the grid should agree with the nodes about
+			where each one is and who its neighbors are.
+		*/
+		unsigned int bad = 0;
+
+		for (unsigned int i = 0; i < nodes.Size(); i++)
+		{
+			HexCoord coord = Locate(nodes.center[i]);
+			HexCoord around[6];
+			unsigned int count = Neighbors(coord, around);
+
+			bool agrees = Id(coord) == i && Center(coord) == nodes.center[i] && count == nodes.NeighborCount(i);
+
+			for (unsigned int j = 0; agrees && j < count; j++)
+			{
+				// The rings can start in different places.
+				unsigned int offset = 0;
+				while (offset < count && Id(around[offset]) != nodes.Neighbor(i, 0)) offset++;
+
+				agrees = offset < count && Id(around[(offset + j) % count]) == nodes.Neighbor(i, j);
+			}
+
+			if (!agrees) bad++;
+		}
+
+		if (bad != 0) std::cout << "Found " << bad << " hexes the grid disagrees with." << std::endl;
+#endif
+	}
+
+	/*-----------------------------------------------*/
+	/* Constructor */
+	/*-----------------------------------------------*/
+	HexGrid::HexGrid(const Polyhedron& icosahedron, unsigned int worldSize) : icosahedron(icosahedron)
+	{
+		this->worldSize = worldSize;
+		this->resolution = 3 * (1 << worldSize);
+
+		// All the faces are wound the same way, so one will do.
+		const TriFace& tf = icosahedron.faces[0];
+		glm::vec3 a = icosahedron.vertices[tf.a].vertex;
+		glm::vec3 b = icosahedron.vertices[tf.b].vertex;
+		glm::vec3 c = icosahedron.vertices[tf.c].vertex;
+		clockwise = glm::dot(glm::cross(b - a, c - a), a + b + c) < 0.0f;
+
+		/*
+			Row j holds every i from j % 3 up to the far edge
+			of the face, in steps of three.
+		*/
+		rowStarts.resize(resolution + 1);
+		slotsPerFace = 0;
+
+		for (int j = 0; j <= resolution; j++)
+		{
+			rowStarts[j] = slotsPerFace;
+			if (resolution - j >= j % 3) slotsPerFace += (resolution - j - j % 3) / 3 + 1;
+		}
+
+		ids.assign(icosahedron.faces.size() * slotsPerFace, NoHex);
+	}
+}
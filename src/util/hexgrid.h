@@ -0,0 +1,126 @@
+#ifndef HEXGRID_H
+#define HEXGRID_H
+
+/*
+	hexgrid.h
+
+	Addresses for the hexes of a planet which can be
+	worked out with arithmetic rather than looked up,
+	so we can find a hex's center, its neighbors, or
+	the hex under some point without having to keep
+	the whole planet around.
+*/
+
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "geometry.h"
+#include "workerpool.h"
+
+namespace Mandalin
+{
+	/*-----------------------------------------------*/
+	/* Hex Coordinates */
+	/*-----------------------------------------------*/
+	/*
+		A hex is given by one of the twenty faces of the
+		icosahedron we started from and where on that face
+		it sits. i runs from the face's first corner toward
+		its second and j toward its third, both in thirds
+		of a subdivided edge, so that face hexes land on
+		whole numbers too:
+
+			vertex hexes		i, j multiples of 3
+			face hexes			i, j one more or two more
+
+		Either way, i and j always leave the same remainder
+		when divided by three.
+
+		A hex on the edge of a face (or on one of its
+		corners) has more than one coordinate, one for each
+		face it touches. Canonical picks out one of them.
+	*/
+	struct HexCoord
+	{
+		unsigned int			face;
+		int						i;
+		int						j;
+	};
+
+	/*-----------------------------------------------*/
+	/* Hex Grid */
+	/*-----------------------------------------------*/
+	class HexGrid
+	{
+	private:
+		/*-----------------------------------------------*/
+		/* Icosahedron */
+		/*-----------------------------------------------*/
+		/*
+			The unsubdivided polyhedron, which tells us which
+			faces meet along each edge and around each corner.
+		*/
+		Polyhedron				icosahedron;
+		unsigned int			worldSize;
+		bool					clockwise;
+
+		// The length of an icosahedron edge, in thirds.
+		int						resolution;
+
+		/*-----------------------------------------------*/
+		/* Storage Ids */
+		/*-----------------------------------------------*/
+		/*
+			The id (node index, or chunk->hexStart + index)
+			of the hex at each canonical coordinate, face by
+			face and row by row.
+		*/
+		std::vector<unsigned int>	rowStarts;
+		unsigned int			slotsPerFace;
+		std::vector<unsigned int>	ids;
+
+		unsigned int			Slot(HexCoord coord) const;
+		HexCoord				Across(unsigned int face, unsigned int edge, int weights[3]) const;
+		HexCoord				Wrap(unsigned int face, int weights[3]) const;
+
+	public:
+		static constexpr unsigned int	NoHex = 0xFFFFFFFF;
+
+		/*-----------------------------------------------*/
+		/* Coordinates */
+		/*-----------------------------------------------*/
+		HexCoord				Canonical(HexCoord coord) const;
+		bool					IsPentagon(HexCoord coord) const;
+
+		glm::vec3				Center(HexCoord coord) const;
+
+		/*
+			Writes the neighbors of a hex into out (which needs
+			room for six), counter-clockwise looking down on the
+			planet, and returns how many there were.
+		*/
+		unsigned int			Neighbors(HexCoord coord, HexCoord* out) const;
+
+		// The hex whose center is nearest the given direction.
+		HexCoord				Locate(glm::vec3 direction) const;
+
+		/*-----------------------------------------------*/
+		/* Storage Ids */
+		/*-----------------------------------------------*/
+		unsigned int			Id(HexCoord coord) const;
+
+		/*
+			Records the id of every node, which has to be done
+			again if the nodes are ever put in a new order.
+		*/
+		void					Index(const HexNodes& nodes, WorkerPool& workers);
+
+		/*-----------------------------------------------*/
+		/* Constructor */
+		/*-----------------------------------------------*/
+		// Takes the icosahedron before it's been subdivided.
+		HexGrid(const Polyhedron& icosahedron, unsigned int worldSize);
+	};
+}
+
+#endif
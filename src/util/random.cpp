@@ -0,0 +1,41 @@
+#include "random.h"
+
+namespace Mandalin
+{
+	/*-----------------------------------------------*/
+	/* Mixing */
+	/*-----------------------------------------------*/
+	uint64_t Mix(uint64_t x)
+	{
+		// SplitMix64's finalizer.
+		x += 0x9E3779B97F4A7C15ull;
+		x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+		x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+		return x ^ (x >> 31);
+	}
+
+	/*-----------------------------------------------*/
+	/* Random */
+	/*-----------------------------------------------*/
+	uint64_t Random::Next()
+	{
+		return Mix(key ^ Mix(counter++));
+	}
+
+	int Random::Range(int n)
+	{
+		if (n <= 0) return 0;
+		return (int)(Next() % (uint64_t)n);
+	}
+
+	double Random::Uniform()
+	{
+		// The top 53 bits fill a double's mantissa exactly.
+		return (Next() >> 11) * (1.0 / 9007199254740992.0);
+	}
+
+	Random::Random(uint64_t seed, uint64_t tick, uint64_t stream)
+	{
+		key = Mix(Mix(Mix(seed) ^ tick) ^ stream);
+	}
+}
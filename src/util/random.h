@@ -0,0 +1,81 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+/*
+	random.h
+
+	A small counter-based random number generator.
+	Rather than carrying state forward from one call
+	to the next like rand(), each number is a hash of
+	a key and a counter, so any stream can be picked
+	up anywhere (and on any thread) just by knowing
+	what it is keyed by.
+*/
+
+#include <cstdint>
+
+namespace Mandalin
+{
+	/*-----------------------------------------------*/
+	/* Mixing */
+	/*-----------------------------------------------*/
+	uint64_t Mix(uint64_t x);
+
+	/*-----------------------------------------------*/
+	/* Random */
+	/*-----------------------------------------------*/
+	/*
+		A stream keyed by (seed, tick, stream). In the
+		simulation, the stream is usually a hex's id, so
+		every hex rolls the same dice every tick no matter
+		which thread gets to it.
+	*/
+	class Random
+	{
+	private:
+		uint64_t		key;
+		uint64_t		counter = 0;
+
+	public:
+		uint64_t		Next();
+
+		// An integer in [0, n).
+		int				Range(int n);
+
+		// A double in [0, 1).
+		double			Uniform();
+
+		Random(uint64_t seed, uint64_t tick, uint64_t stream);
+	};
+
+	/*-----------------------------------------------*/
+	/* World Seed */
+	/*-----------------------------------------------*/
+	/*
+		The stages of world generation (and the history
+		that follows it) which each get their own stream,
+		so that changing how many numbers one stage draws
+		doesn't reshuffle every stage after it.
+	*/
+	enum class SeedStage { palette, voronoi, topology, biomes, rivers, history, ocean };
+
+	/*
+		The one number a whole world grows out of. The
+		same seed always gives back the same world.
+	*/
+	class WorldSeed
+	{
+	private:
+		uint64_t		value;
+
+	public:
+		uint64_t		Value() const { return value; }
+
+		uint64_t		StageSeed(SeedStage stage) const { return Mix(value ^ Mix((uint64_t)stage + 1)); }
+		Random			Stream(SeedStage stage) const { return Random(StageSeed(stage), 0, 0); }
+
+		WorldSeed(uint64_t value) { this->value = value; }
+	};
+}
+
+#endif
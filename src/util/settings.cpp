@@ -1,6 +1,6 @@
 #include "settings.h"
 
-#include <time.h>
+#include <cmath>
 
 #include "../world/hex.h"
 
@@ -8,10 +8,26 @@ namespace Mandalin
 {
 	glm::vec4 Settings::BiomeColors[64];
 	glm::vec4 Settings::TectonicPlateColors[64];
+	glm::vec4 Settings::IdentityColors[IdentityColorCount];
+	unsigned int Settings::PaletteVersion = 0;
+
+	/*
+		A small random offset for each variation of a biome's color.
+		The draws are made one after another so that a seed gives the
+		same colors whatever order a compiler evaluates arguments in.
+	*/
+	static glm::vec4 Jitter(Random& rng)
+	{
+		float r = (rng.Range(10) / 100.0f) - 0.2f;
+		float g = (rng.Range(10) / 100.0f) - 0.2f;
+		float b = (rng.Range(10) / 100.0f) - 0.2f;
+
+		return glm::vec4(r, g, b, 0.0f);
+	}
 
-	void Settings::Setup()
+	void Settings::Setup(WorldSeed seed)
 	{
-		srand(time(NULL));
+		Random rng = seed.Stream(SeedStage::palette);
 
 		int i = 0;
 		
@@ -21,85 +37,105 @@ namespace Mandalin
 		// MOUNTAIN
 		for (int iter = 0; iter < 5; iter++)
 		{
-			glm::vec4 r = glm::vec4(((rand() % 10) / 100.0f) - 0.2f, ((rand() % 10) / 100.0f) - 0.2f, ((rand() % 10) / 100.0f) - 0.2f, 0.0f);
+			glm::vec4 r = Jitter(rng);
 			BiomeColors[i++] = MountainColor + r;
 		}
 
 		// HIGHLANDS
 		for (int iter = 0; iter < 5; iter++)
 		{
-			glm::vec4 r = glm::vec4(((rand() % 10) / 100.0f) - 0.2f, ((rand() % 10) / 100.0f) - 0.2f, ((rand() % 10) / 100.0f) - 0.2f, 0.0f);
+			glm::vec4 r = Jitter(rng);
 			BiomeColors[i++] = HighlandColor + r;
 		}
 
 		// DESERTS
 		for (int iter = 0; iter < 5; iter++)
 		{
-			glm::vec4 r = glm::vec4(((rand() % 10) / 100.0f) - 0.2f, ((rand() % 10) / 100.0f) - 0.2f, ((rand() % 10) / 100.0f) - 0.2f, 0.0f);
+			glm::vec4 r = Jitter(rng);
 			BiomeColors[i++] = DesertColor + r;
 		}
 
 		// STEPPES
 		for (int iter = 0; iter < 5; iter++)
 		{
-			glm::vec4 r = glm::vec4(((rand() % 10) / 100.0f) - 0.2f, ((rand() % 10) / 100.0f) - 0.2f, ((rand() % 10) / 100.0f) - 0.2f, 0.0f);
+			glm::vec4 r = Jitter(rng);
 			BiomeColors[i++] = SteppeColor + r;
 		}
 
 		// SAVANNAS
 		for (int iter = 0; iter < 5; iter++)
 		{
-			glm::vec4 r = glm::vec4(((rand() % 10) / 100.0f) - 0.2f, ((rand() % 10) / 100.0f) - 0.2f, ((rand() % 10) / 100.0f) - 0.2f, 0.0f);
+			glm::vec4 r = Jitter(rng);
 			BiomeColors[i++] = SavannaColor + r;
 		}
 
 		// DRY FORESTS
 		for (int iter = 0; iter < 5; iter++)
 		{
-			glm::vec4 r = glm::vec4(((rand() % 10) / 100.0f) - 0.2f, ((rand() % 10) / 100.0f) - 0.2f, ((rand() % 10) / 100.0f) - 0.2f, 0.0f);
+			glm::vec4 r = Jitter(rng);
 			BiomeColors[i++] = DryForestColor + r;
 		}
 
 		// BROADLEAF FORESTS
 		for (int iter = 0; iter < 5; iter++)
 		{
-			glm::vec4 r = glm::vec4(((rand() % 10) / 100.0f) - 0.2f, ((rand() % 10) / 100.0f) - 0.2f, ((rand() % 10) / 100.0f) - 0.2f, 0.0f);
+			glm::vec4 r = Jitter(rng);
 			BiomeColors[i++] = BroadleafForestColor + r;
 		}
 
 		// RAINFORESTS
 		for (int iter = 0; iter < 5; iter++)
 		{
-			glm::vec4 r = glm::vec4(((rand() % 10) / 100.0f) - 0.2f, ((rand() % 10) / 100.0f) - 0.2f, ((rand() % 10) / 100.0f) - 0.2f, 0.0f);
+			glm::vec4 r = Jitter(rng);
 			BiomeColors[i++] = RainforestColor + r;
 		}
 
 		// TUNDRA
 		for (int iter = 0; iter < 5; iter++)
 		{
-			glm::vec4 r = glm::vec4(((rand() % 10) / 100.0f) - 0.2f, ((rand() % 10) / 100.0f) - 0.2f, ((rand() % 10) / 100.0f) - 0.2f, 0.0f);
+			glm::vec4 r = Jitter(rng);
 			BiomeColors[i++] = TundraColor + r;
 		}
 
 		// TAIGA
 		for (int iter = 0; iter < 5; iter++)
 		{
-			glm::vec4 r = glm::vec4(((rand() % 10) / 100.0f) - 0.2f, ((rand() % 10) / 100.0f) - 0.2f, ((rand() % 10) / 100.0f) - 0.2f, 0.0f);
+			glm::vec4 r = Jitter(rng);
 			BiomeColors[i++] = TaigaColor + r;
 		}
 
 		//  MEDITERRANEAN
 		for (int iter = 0; iter < 5; iter++)
 		{
-			glm::vec4 r = glm::vec4(((rand() % 10) / 100.0f) - 0.2f, ((rand() % 10) / 100.0f) - 0.2f, ((rand() % 10) / 100.0f) - 0.2f, 0.0f);
+			glm::vec4 r = Jitter(rng);
 			BiomeColors[i++] = MediterraneanColor + r;
 		}
 
 		//  OCEANIC
 		for (int iter = 0; iter < 5; iter++)
 		{
-			glm::vec4 r = glm::vec4(((rand() % 10) / 100.0f) - 0.2f, ((rand() % 10) / 100.0f) - 0.2f, ((rand() % 10) / 100.0f) - 0.2f, 0.0f);
+			glm::vec4 r = Jitter(rng);
 			BiomeColors[i++] = OceanicColor + r;
 		}
+
+		/*
+			The identity colors are the same for every seed:
+			each channel is the usual sine hash of the id (or
+			the id plus one or two).
+		*/
+		for (unsigned int id = 0; id < IdentityColorCount; id++)
+		{
+			float channels[3];
+
+			for (int c = 0; c < 3; c++)
+			{
+				float h = sinf((float)(id + c)) * 43758.5453123f;
+				channels[c] = h - floorf(h);
+			}
+
+			IdentityColors[id] = glm::vec4(channels[0], channels[1], channels[2], 1.0f);
+		}
+
+		PaletteVersion++;
 	}
 }
\ No newline at end of file
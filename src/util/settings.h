@@ -5,6 +5,8 @@
 
 #include <glm/glm.hpp>
 
+#include "random.h"
+
 namespace Mandalin
 {
 	struct Settings
@@ -19,6 +21,18 @@ namespace Mandalin
 		/*-------------------------------------------------*/
 		static constexpr float			TicRate = 1.0f;
 
+		// How many years a headless run simulates
+		// unless told otherwise.
+		static constexpr unsigned int	HeadlessYears = 100;
+
+		// How many threads share the population tick.
+		// Zero uses every hardware thread.
+		static constexpr unsigned int	SimulationThreads = 0;
+
+		// How many threads world generation spreads its
+		// per-hex work over. Zero uses every hardware thread.
+		static constexpr unsigned int	WorldGenThreads = 0;
+
 		/*-------------------------------------------------*/
 		/* Chronology                                      */
 		/*-------------------------------------------------*/
@@ -77,14 +91,50 @@ namespace Mandalin
 		/*-------------------------------------------------*/
 		static constexpr float			OceanOffset = 0.99f;
 
+		// The ocean's patches are the faces of an icosahedron
+		// subdivided this many times.
+		static constexpr int			OceanPatchLevel = 2;
+
+		/*
+			A patch is cut into up to this many segments along
+			each edge (a power of two), as few as keeps each
+			cell about OceanCellPixels across on screen.
+		*/
+		static constexpr unsigned int	OceanMaxSegments = 16;
+
+		// The finest mesh's grid and skirt have to fit in
+		// 16-bit indices too.
+		static_assert((OceanMaxSegments + 1) * (OceanMaxSegments + 2) / 2 + 3 * (OceanMaxSegments + 1) <= 65536, "The ocean's meshes must fit in 16-bit indices.");
+		static constexpr float			OceanCellPixels = 24.0f;
+
+		static constexpr float			OceanWaveHeight = 0.25f;
+		static constexpr float			OceanSkirtDepth = 1.0f;
+		static constexpr unsigned int	OceanNoiseSize = 256;
+
 		/*-------------------------------------------------*/
 		/* Chunks                                          */
 		/*-------------------------------------------------*/
 		static constexpr unsigned int	ChunkMaxHexes = 300;
-		static constexpr unsigned int	ChunkTrisPerHex = 18;
-		static constexpr unsigned int	ChunkMaxTris = (ChunkMaxHexes * ChunkTrisPerHex);
 
-		static constexpr unsigned int	OceanChunkMaxTris = 10000;
+		/*
+			A chunk's meshes are indexed with 16 bits, so a full
+			mesh has to fit in 65,536 vertices. At worst a hex
+			has a center and six corners on top, its own copy
+			of the six corners for its sides, and two more for
+			the bottom of each side.
+		*/
+		static constexpr unsigned int	ChunkMaxVertsPerHex = 1 + 6 + 6 + 2 * 6;
+		static_assert(ChunkMaxHexes * ChunkMaxVertsPerHex <= 65536, "A chunk's vertices must fit in 16-bit indices.");
+
+		/*
+			Once a chunk's hexes are less than this many pixels
+			across, it's drawn from its coarse mesh, and it only
+			goes back to the full one when they're bigger than
+			this times LodHysteresis (so a chunk sitting right
+			on the line doesn't flicker between the two).
+		*/
+		static constexpr float			LodHexPixels = 12.0f;
+		static constexpr float			LodHysteresis = 1.25f;
 
 		/*------------------------------------------------------------------------------------------------------*/
 		/*  --  --  --  --  --  --  --  --  --  --  --  --  --  --  --  --  --  --  --  --  --  --  --  --  --  */
@@ -141,10 +191,21 @@ namespace Mandalin
 		static glm::vec4										BiomeColors[64];
 		static glm::vec4										TectonicPlateColors[64];
 
+		/*
+			A color for each population and language, by id
+			(wrapping around once the ids run past the end).
+		*/
+		static constexpr unsigned int							IdentityColorCount = 4096;
+		static glm::vec4										IdentityColors[IdentityColorCount];
+
+		// Goes up whenever any of the maps above changes,
+		// so anything holding a copy knows to refresh it.
+		static unsigned int										PaletteVersion;
+
 		/*-------------------------------------------------*/
 		/* Setup                                           */
 		/*-------------------------------------------------*/
-		static void Setup();
+		static void Setup(WorldSeed seed);
 	};
 }
 
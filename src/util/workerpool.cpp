@@ -0,0 +1,97 @@
+#include "workerpool.h"
+
+namespace Mandalin
+{
+	/*-----------------------------------------------*/
+	/* Jobs */
+	/*-----------------------------------------------*/
+	void WorkerPool::RunJob()
+	{
+		while (true)
+		{
+			unsigned int i = next.fetch_add(1);
+			if (i >= jobCount) break;
+			(*job)(i);
+		}
+	}
+
+	void WorkerPool::WorkerLoop()
+	{
+		unsigned int seen = 0;
+
+		while (true)
+		{
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				wake.wait(lock, [&] { return stopping || generation != seen; });
+
+				if (stopping) return;
+				seen = generation;
+			}
+
+			RunJob();
+
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				busy--;
+			}
+			done.notify_one();
+		}
+	}
+
+	void WorkerPool::ParallelFor(unsigned int count, const std::function<void(unsigned int)>& fn)
+	{
+		if (count == 0) return;
+
+		// Not worth waking anyone up for.
+		if (workers.empty() || count == 1)
+		{
+			for (unsigned int i = 0; i < count; i++) fn(i);
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			job = &fn;
+			jobCount = count;
+			next = 0;
+			busy = workers.size();
+			generation++;
+		}
+		wake.notify_all();
+
+		RunJob();
+
+		std::unique_lock<std::mutex> lock(mutex);
+		done.wait(lock, [&] { return busy == 0; });
+		job = nullptr;
+	}
+
+	/*-----------------------------------------------*/
+	/* Constructor & Deconstructor */
+	/*-----------------------------------------------*/
+	WorkerPool::WorkerPool(unsigned int threadCount)
+	{
+		if (threadCount == 0) threadCount = std::thread::hardware_concurrency();
+		if (threadCount == 0) threadCount = 1;
+
+		next = 0;
+
+		// The thread calling ParallelFor pitches in too.
+		for (unsigned int i = 1; i < threadCount; i++)
+		{
+			workers.push_back(std::thread(&WorkerPool::WorkerLoop, this));
+		}
+	}
+
+	WorkerPool::~WorkerPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		wake.notify_all();
+
+		for (int i = 0; i < workers.size(); i++) workers[i].join();
+	}
+}
@@ -0,0 +1,69 @@
+#ifndef WORKERPOOL_H
+#define WORKERPOOL_H
+
+/*
+	workerpool.h
+
+	A handful of threads that sit around waiting to
+	be handed a loop to split between themselves.
+*/
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <condition_variable>
+
+namespace Mandalin
+{
+	class WorkerPool
+	{
+	private:
+		/*-----------------------------------------------*/
+		/* Threads */
+		/*-----------------------------------------------*/
+		std::vector<std::thread>				workers;
+
+		std::mutex								mutex;
+		std::condition_variable					wake;
+		std::condition_variable					done;
+
+		bool									stopping = false;
+		unsigned int							generation = 0;
+		unsigned int							busy = 0;
+
+		/*-----------------------------------------------*/
+		/* Current Job */
+		/*-----------------------------------------------*/
+		const std::function<void(unsigned int)>*	job = nullptr;
+		unsigned int							jobCount = 0;
+		std::atomic<unsigned int>				next;
+
+		void									RunJob();
+		void									WorkerLoop();
+
+	public:
+		/*-----------------------------------------------*/
+		/* Jobs */
+		/*-----------------------------------------------*/
+		unsigned int							ThreadCount() { return workers.size() + 1; }
+
+		/*
+			Calls fn(i) for every i in [0, count), spread over
+			the workers and the calling thread, and returns
+			once all of them are finished. The order in which
+			the calls happen is not defined.
+		*/
+		void									ParallelFor(unsigned int count, const std::function<void(unsigned int)>& fn);
+
+		/*-----------------------------------------------*/
+		/* Constructor & Deconstructor */
+		/*-----------------------------------------------*/
+		// A thread count of 0 uses every hardware thread.
+		WorkerPool(unsigned int threadCount);
+		~WorkerPool();
+	};
+}
+
+#endif
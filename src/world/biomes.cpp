@@ -1,5 +1,4 @@
 #include "biomes.h"
-#include <time.h>
 #include <iostream>
 
 namespace Mandalin
@@ -48,18 +47,20 @@ namespace Mandalin
 		return 0;
 	}
 
-	unsigned int FindNearestLateralNeighbor(HexNode node, std::vector<HexNode> neighbors, glm::vec3 target)
+
+	unsigned int FindNearestLateralNeighbor(const HexNodes& hexNodes, unsigned int node, glm::vec3 target)
 	{
 		float minDist = INFINITY;
 		unsigned int minIndex = 0;
 
-		for (int i = 0; i < neighbors.size(); i++)
+		for (unsigned int i = hexNodes.neighborOffsets[node]; i < hexNodes.neighborOffsets[node + 1]; i++)
 		{
-			float dist = glm::distance(neighbors[i].center, target);
+			unsigned int neighbor = hexNodes.neighbors[i];
+			float dist = glm::distance(hexNodes.center[neighbor], target);
 			
-			if (dist < minDist && abs(neighbors[i].latitude - node.latitude) < 0.01f)
+			if (dist < minDist && abs(hexNodes.latitude[neighbor] - hexNodes.latitude[node]) < 0.01f)
 			{
-				minIndex = neighbors[i].index;
+				minIndex = neighbor;
 				minDist = dist;
 			}
 		}
@@ -67,73 +68,68 @@ namespace Mandalin
 		return minIndex;
 	}
 
-	std::vector<HexNode> SmoothClimate(std::vector<HexNode> hexNodes)
+	void SmoothClimate(WorldGenContext& context)
 	{
+		HexNodes& hexNodes = context.nodes;
+
 		/*
 			Now, we're going to smooth rainfall and temp
 			out and clamp their values.
 		*/
-		std::vector<float> temps;
-		std::vector<float> rains;
+		std::vector<float> temps(hexNodes.Size());
+		std::vector<float> rains(hexNodes.Size());
 
-		for (int i = 0; i < hexNodes.size(); i++)
+		for (unsigned int i = 0; i < hexNodes.Size(); i++)
 		{
-			HexNode* hn = &hexNodes[i];
-
-			float aveRain = hn->rainfall;
-			float aveTemp = hn->temperature;
+			float aveRain = hexNodes.rainfall[i];
+			float aveTemp = hexNodes.temperature[i];
 
-			for (int j = 0; j < hn->neighbors.size(); j++)
+			for (unsigned int j = hexNodes.neighborOffsets[i]; j < hexNodes.neighborOffsets[i + 1]; j++)
 			{
-				aveRain += hexNodes[hn->neighbors[j]].rainfall;
-				aveTemp += hexNodes[hn->neighbors[j]].temperature;
+				aveRain += hexNodes.rainfall[hexNodes.neighbors[j]];
+				aveTemp += hexNodes.temperature[hexNodes.neighbors[j]];
 			}
 
-			aveRain /= (hn->neighbors.size() + 1);
-			aveTemp /= (hn->neighbors.size() + 1);
+			aveRain /= (hexNodes.NeighborCount(i) + 1);
+			aveTemp /= (hexNodes.NeighborCount(i) + 1);
 
-			rains.push_back(aveRain);
-			temps.push_back(aveTemp);
+			rains[i] = aveRain;
+			temps[i] = aveTemp;
 		}
 
-		for (int i = 0; i < hexNodes.size(); i++)
+		for (unsigned int i = 0; i < hexNodes.Size(); i++)
 		{
-			HexNode* hn = &hexNodes[i];
-
-			hn->rainfall = std::max(std::min(rains[i], 5000.0f), 0.0f);
-			hn->temperature = std::max(std::min(temps[i], 30.0f), -25.0f);
+			hexNodes.rainfall[i] = std::max(std::min(rains[i], 5000.0f), 0.0f);
+			hexNodes.temperature[i] = std::max(std::min(temps[i], 30.0f), -25.0f);
 		}
-
-		rains.clear();
-		temps.clear();
-
-		return hexNodes;
 	}
 
-	std::vector<HexNode> GenerateClimate(std::vector<HexNode> hexNodes, glm::vec3 planetPosition, float planetRadius)
+	void GenerateClimate(WorldGenContext& context)
 	{
+		HexNodes& hexNodes = context.nodes;
+		glm::vec3 planetPosition = context.planetPosition;
+		float planetRadius = context.planetRadius;
+
 		/*
 			First, we lay some rough groundwork.
 		*/
-		for (int i = 0; i < hexNodes.size(); i++)
+		for (unsigned int i = 0; i < hexNodes.Size(); i++)
 		{
-			HexNode* hn = &hexNodes[i];
+			float unweightedLatitude = abs(hexNodes.center[i].y - planetPosition.y) / planetRadius;
 
-			float unweightedLatitude = abs(hn->center.y - planetPosition.y) / planetRadius;
+			hexNodes.latitude[i] = 0.9f * unweightedLatitude;
+			hexNodes.temperature[i] = Lerp(30.0f, -25.0f, unweightedLatitude);
+			hexNodes.rainfall[i] = Lerp(5000.0f, 0.0f, unweightedLatitude);
 
-			hn->latitude = 0.9f * unweightedLatitude;
-			hn->temperature = Lerp(30.0f, -25.0f, unweightedLatitude);
-			hn->rainfall = Lerp(5000.0f, 0.0f, unweightedLatitude);
-
-			if (hn->biome == Biome::mountain)
+			if (hexNodes.biome[i] == Biome::mountain)
 			{
-				hn->temperature *= 0.6f;
-				hn->rainfall *= 0.5f;
+				hexNodes.temperature[i] *= 0.6f;
+				hexNodes.rainfall[i] *= 0.5f;
 			}
-			else if (hn->biome == Biome::highlands)
+			else if (hexNodes.biome[i] == Biome::highlands)
 			{
-				hn->temperature *= 0.8f;
-				hn->rainfall *= 0.9f;
+				hexNodes.temperature[i] *= 0.8f;
+				hexNodes.rainfall[i] *= 0.9f;
 			}
 		}
 
@@ -142,36 +138,33 @@ namespace Mandalin
 			(and where rain is stronger than usual).
 		*/
 
-		for (int i = 0; i < hexNodes.size(); i++)
+		for (unsigned int i = 0; i < hexNodes.Size(); i++)
 		{
-			HexNode* hn = &hexNodes[i];
-
-			if (hn->biome != Biome::mountain) continue;
+			if (hexNodes.biome[i] != Biome::mountain) continue;
 
 			/*
 				Now, we need to figure out which way the wind
 				is a-blowin'. We are going to first add rain
 				shadows to our mountains.
 			*/
-			HexNode* current = hn;
+			unsigned int current = i;
 
 			for (int j = 0; j < Settings::WindStrength; j++)
 			{
 				// I know. Anyways...
-				if (current->biome != Biome::mountain) current->rainfall *= 0.5f;
+				if (hexNodes.biome[current] != Biome::mountain) hexNodes.rainfall[current] *= 0.5f;
 
 				// Now, since I can find no easier way,
 				// we need to find our next hex in a more
 				// complicated fashion than I'd prefer.
-				glm::vec3 target = current->center;
+				glm::vec3 center = hexNodes.center[current];
+				float latitude = hexNodes.latitude[current];
+				glm::vec3 target = center;
 
-				if (current->latitude > Settings::HadleyCutoff && current->latitude < Settings::FerrelCutoff) target = RotateRelative(planetPosition, current->center, Quaternion(0.5f, 0.0f, 1.0f, 0.0f));	// Rotate it west.
-				else target = RotateRelative(planetPosition, current->center, Quaternion(0.5f, 0.0f, -1.0f, 0.0f)); // Rotate it east.
+				if (latitude > Settings::HadleyCutoff && latitude < Settings::FerrelCutoff) target = RotateRelative(planetPosition, center, Quaternion(0.5f, 0.0f, 1.0f, 0.0f));	// Rotate it west.
+				else target = RotateRelative(planetPosition, center, Quaternion(0.5f, 0.0f, -1.0f, 0.0f)); // Rotate it east.
 
-				std::vector<HexNode> neighbors;
-				for (int k = 0; k < current->neighbors.size(); k++) neighbors.push_back(hexNodes[current->neighbors[k]]);
-
-				current = &hexNodes[FindNearestLateralNeighbor(*current, neighbors, target)];
+				current = FindNearestLateralNeighbor(hexNodes, current, target);
 			}
 
 			/*
@@ -182,21 +175,21 @@ namespace Mandalin
 				struck previously.
 			*/
 			bool hitWater = false;
-			std::vector<HexNode*> line;
+			std::vector<unsigned int> line;
 			for (int j = 0; j < Settings::WindStrength; j++)
 			{
 				line.push_back(current);
-				glm::vec3 target = current->center;
 
-				if (current->latitude > Settings::HadleyCutoff && current->latitude < Settings::FerrelCutoff) target = RotateRelative(planetPosition, current->center, Quaternion(0.5f, 0.0f, -1.0f, 0.0f));	// Rotate it east.
-				else target = RotateRelative(planetPosition, current->center, Quaternion(0.5f, 0.0f, 1.0f, 0.0f)); // Rotate it west.
+				glm::vec3 center = hexNodes.center[current];
+				float latitude = hexNodes.latitude[current];
+				glm::vec3 target = center;
 
-				std::vector<HexNode> neighbors;
-				for (int k = 0; k < current->neighbors.size(); k++) neighbors.push_back(hexNodes[current->neighbors[k]]);
+				if (latitude > Settings::HadleyCutoff && latitude < Settings::FerrelCutoff) target = RotateRelative(planetPosition, center, Quaternion(0.5f, 0.0f, -1.0f, 0.0f));	// Rotate it east.
+				else target = RotateRelative(planetPosition, center, Quaternion(0.5f, 0.0f, 1.0f, 0.0f)); // Rotate it west.
 
-				current = &hexNodes[FindNearestLateralNeighbor(*current, neighbors, target)];
+				current = FindNearestLateralNeighbor(hexNodes, current, target);
 
-				if (current->biome == Biome::ocean)
+				if (hexNodes.biome[current] == Biome::ocean)
 				{
 					hitWater = true;
 					break;
@@ -207,7 +200,7 @@ namespace Mandalin
 			{
 				for (int j = 0; j < line.size(); j++)
 				{
-					line[j]->rainfall *= 1.25f * (1.0f - (j / line.size()));
+					hexNodes.rainfall[line[j]] *= 1.25f * (1.0f - (j / line.size()));
 				}
 			}
 		}
@@ -217,30 +210,30 @@ namespace Mandalin
 			out and clamp their values.
 		*/
 
-		return SmoothClimate(hexNodes);
+		SmoothClimate(context);
 	}
 
-	std::vector<HexNode> GenerateBiomes(std::vector<HexNode> hexNodes, glm::vec3 planetPosition, float planetRadius)
+	void GenerateBiomes(WorldGenContext& context)
 	{
-		srand(time(NULL));
+		HexNodes& hexNodes = context.nodes;
+		glm::vec3 planetPosition = context.planetPosition;
+		Random rng = context.seed.Stream(SeedStage::biomes);
 
 		/*
 			First, we're going to add some islands around underwater
 			faultlines.
 		*/
-		for (int i = 0; i < hexNodes.size(); i++)
+		for (unsigned int i = 0; i < hexNodes.Size(); i++)
 		{
-			HexNode* hn = &hexNodes[i];
-
-			if (!hn->ocean) continue;
+			if (!hexNodes.Has(i, NodeFlag::ocean)) continue;
 
-			if ((hn->faultNeighbor || hn->fault) && rand() % 100 > Settings::IslandInitialChance)
+			if ((hexNodes.Has(i, NodeFlag::faultNeighbor) || hexNodes.Has(i, NodeFlag::fault)) && rng.Range(100) > Settings::IslandInitialChance)
 			{
-				hn->island = true;
-				hn->ocean = false;
-				hn->oceanNeighbor = true;
-				hn->biome = Biome::broadleafforest;
-				hn->biomeVariation = rand() % 5;
+				hexNodes.Set(i, NodeFlag::island);
+				hexNodes.Set(i, NodeFlag::ocean, false);
+				hexNodes.Set(i, NodeFlag::oceanNeighbor);
+				hexNodes.biome[i] = Biome::broadleafforest;
+				hexNodes.biomeVariation[i] = rng.Range(5);
 			}
 		}
 
@@ -249,32 +242,30 @@ namespace Mandalin
 		*/
 		for (int iter = 0; iter < Settings::IslandSpreadingIterations; iter++)
 		{
-			for (int i = 0; i < hexNodes.size(); i++)
+			for (unsigned int i = 0; i < hexNodes.Size(); i++)
 			{
-				HexNode* hn = &hexNodes[i];
-
-				if (!hn->island) continue;
+				if (!hexNodes.Has(i, NodeFlag::island)) continue;
 
 				bool oceanNeighbor = false;
 
-				for (int j = 0; j < hn->neighbors.size(); j++)
+				for (unsigned int j = hexNodes.neighborOffsets[i]; j < hexNodes.neighborOffsets[i + 1]; j++)
 				{
-					HexNode* neighbor = &hexNodes[hn->neighbors[j]];
+					unsigned int neighbor = hexNodes.neighbors[j];
 
-					if (!neighbor->ocean) continue;
+					if (!hexNodes.Has(neighbor, NodeFlag::ocean)) continue;
 
-					if (rand() % 100 > Settings::IslandSpreadChance)
+					if (rng.Range(100) > Settings::IslandSpreadChance)
 					{
-						neighbor->island = true;
-						neighbor->ocean = false;
-						neighbor->oceanNeighbor = true;
-						neighbor->biome = Biome::broadleafforest;
-						neighbor->biomeVariation = rand() % 5;
+						hexNodes.Set(neighbor, NodeFlag::island);
+						hexNodes.Set(neighbor, NodeFlag::ocean, false);
+						hexNodes.Set(neighbor, NodeFlag::oceanNeighbor);
+						hexNodes.biome[neighbor] = Biome::broadleafforest;
+						hexNodes.biomeVariation[neighbor] = rng.Range(5);
 					}
 					else oceanNeighbor = true;
 				}
 
-				hn->oceanNeighbor = oceanNeighbor;
+				hexNodes.Set(i, NodeFlag::oceanNeighbor, oceanNeighbor);
 			}
 		}
 
@@ -284,33 +275,29 @@ namespace Mandalin
 
 			This is going to be a multi-stage process.
 		*/
-		for (int i = 0; i < hexNodes.size(); i++)
+		for (unsigned int i = 0; i < hexNodes.Size(); i++)
 		{
-			HexNode* hn = &hexNodes[i];
+			bool fault = hexNodes.Has(i, NodeFlag::fault);
 
-			if (hn->ocean) hn->biome = Biome::ocean;
-			else if (hn->island && !hn->fault) hn->biome = Biome::broadleafforest;
-			else if (hn->faultNeighbor || (hn->fault && hn->oceanNeighbor)) hn->biome = Biome::highlands;
-			else if (hn->fault) hn->biome = Biome::mountain;
+			if (hexNodes.Has(i, NodeFlag::ocean)) hexNodes.biome[i] = Biome::ocean;
+			else if (hexNodes.Has(i, NodeFlag::island) && !fault) hexNodes.biome[i] = Biome::broadleafforest;
+			else if (hexNodes.Has(i, NodeFlag::faultNeighbor) || (fault && hexNodes.Has(i, NodeFlag::oceanNeighbor))) hexNodes.biome[i] = Biome::highlands;
+			else if (fault) hexNodes.biome[i] = Biome::mountain;
 		}
 
 		/*
 			Quickly, we need to iterate over our islands to
 			fix our highlands and mountains.
 		*/
-		for (int i = 0; i < hexNodes.size(); i++)
+		for (unsigned int i = 0; i < hexNodes.Size(); i++)
 		{
-			HexNode* hn = &hexNodes[i];
-
-			if (!hn->island) continue;
+			if (!hexNodes.Has(i, NodeFlag::island)) continue;
 
-			for (int j = 0; j < hn->neighbors.size(); j++)
+			for (unsigned int j = hexNodes.neighborOffsets[i]; j < hexNodes.neighborOffsets[i + 1]; j++)
 			{
-				HexNode* neighbor = &hexNodes[hn->neighbors[j]];
-
-				if (neighbor->biome == Biome::mountain)
+				if (hexNodes.biome[hexNodes.neighbors[j]] == Biome::mountain)
 				{
-					hn->biome = Biome::highlands;
+					hexNodes.biome[i] = Biome::highlands;
 					break;
 				}
 			}
@@ -321,32 +308,32 @@ namespace Mandalin
 		*/
 		for (int iter = 0; iter < Settings::MountainSpreadingIterations; iter++)
 		{
-			for (int i = 0; i < hexNodes.size(); i++)
+			for (unsigned int i = 0; i < hexNodes.Size(); i++)
 			{
-				HexNode* hn = &hexNodes[i];
+				Biome biome = hexNodes.biome[i];
 
-				if (hn->biome != Biome::highlands &&
-					hn->biome != Biome::mountain) continue;
+				if (biome != Biome::highlands &&
+					biome != Biome::mountain) continue;
 
-				for (int j = 0; j < hn->neighbors.size(); j++)
+				for (unsigned int j = hexNodes.neighborOffsets[i]; j < hexNodes.neighborOffsets[i + 1]; j++)
 				{
-					HexNode* neighbor = &hexNodes[hn->neighbors[j]];
+					unsigned int neighbor = hexNodes.neighbors[j];
 
-					if (neighbor->biome == Biome::ocean ||
-						neighbor->biome == Biome::mountain ||
-						neighbor->island) continue;
+					if (hexNodes.biome[neighbor] == Biome::ocean ||
+						hexNodes.biome[neighbor] == Biome::mountain ||
+						hexNodes.Has(neighbor, NodeFlag::island)) continue;
 
-					if (neighbor->oceanNeighbor &&
-						hn->biome == Biome::mountain) continue;
+					if (hexNodes.Has(neighbor, NodeFlag::oceanNeighbor) &&
+						biome == Biome::mountain) continue;
 
-					if (neighbor->biome == hn->biome) continue;
+					if (hexNodes.biome[neighbor] == biome) continue;
 
-					int r = rand() % 100 + 1;
-					if (hn->biome == Biome::mountain) r *= 0.6f;
+					int r = rng.Range(100) + 1;
+					if (biome == Biome::mountain) r *= 0.6f;
 
-					if (neighbor->biome != hn->biome && r > 50)
+					if (hexNodes.biome[neighbor] != biome && r > 50)
 					{
-						neighbor->biome = hn->biome;
+						hexNodes.biome[neighbor] = biome;
 						break;
 					}
 				}
@@ -356,114 +343,113 @@ namespace Mandalin
 		/*
 			Now to determine winds, rains, and average temperatures.
 		*/
-		hexNodes = GenerateClimate(hexNodes, planetPosition, planetRadius);
+		GenerateClimate(context);
 
 		/*
 			And now that we've done *all* that, we can figure out our
 			biomes. It should be relatively straightforward.
 		*/
-		for (int i = 0; i < hexNodes.size(); i++)
+		for (unsigned int i = 0; i < hexNodes.Size(); i++)
 		{
-			HexNode* hn = &hexNodes[i];
+			if (hexNodes.biome[i] != Biome::broadleafforest) continue;
 
-			if (hn->biome != Biome::broadleafforest) continue;
+			float rainfall = hexNodes.rainfall[i];
+			float temperature = hexNodes.temperature[i];
+			Biome biome = Biome::broadleafforest;
 
-			if (hn->rainfall < 250 && hn->temperature < -10)
+			if (rainfall < 250 && temperature < -10)
 			{
-				hn->biome = Biome::tundra;
+				biome = Biome::tundra;
 			}
-			else if (hn->rainfall < 1000 && hn->temperature < -10)
+			else if (rainfall < 1000 && temperature < -10)
 			{
-				hn->biome = Biome::taiga;
+				biome = Biome::taiga;
 			}
-			else if (hn->rainfall < 1000)
+			else if (rainfall < 1000)
 			{
-				hn->biome = Biome::desert;
+				biome = Biome::desert;
 			}
-			else if (hn->rainfall < 2000)
+			else if (rainfall < 2000)
 			{
-				hn->biome = Biome::steppe;
+				biome = Biome::steppe;
 			}
-			else if (hn->rainfall < 4500 && hn->temperature > 12.5f)
+			else if (rainfall < 4500 && temperature > 12.5f)
 			{
-				hn->biome = Biome::savanna;
+				biome = Biome::savanna;
 			}
-			else if (hn->rainfall < 4500 && hn->temperature > 10)
+			else if (rainfall < 4500 && temperature > 10)
 			{
-				hn->biome = Biome::dryforest;
+				biome = Biome::dryforest;
 			}
-			else if (hn->rainfall < 4500 && hn->temperature < 10)
+			else if (rainfall < 4500 && temperature < 10)
 			{
-				hn->biome = Biome::broadleafforest;
+				biome = Biome::broadleafforest;
 			}
-			else if (hn->rainfall > 4500)
+			else if (rainfall > 4500)
 			{
-				hn->biome = Biome::rainforest;
+				biome = Biome::rainforest;
 			}
 
+			hexNodes.biome[i] = biome;
+
 			/*
 				Now, we need to handle our "special" biomes
 				such as mediterranean and oceanic climates
 				which depend on ocean currents more.
 			*/
-			if (!hn->oceanNeighbor ||
-				hn->biome == Biome::desert ||
-				hn->biome == Biome::tundra ||
-				hn->biome == Biome::taiga ||
-				hn->biome == Biome::rainforest) continue;
+			if (!hexNodes.Has(i, NodeFlag::oceanNeighbor) ||
+				biome == Biome::desert ||
+				biome == Biome::tundra ||
+				biome == Biome::taiga ||
+				biome == Biome::rainforest) continue;
 
 			/*
 				We're also going to somewhat arbitrarily
 				include a latitude threshold.
 			*/
-			if (hn->latitude < 0.3f) continue;
+			float latitude = hexNodes.latitude[i];
+			if (latitude < 0.3f) continue;
 
 			/*
 				Time to whip out the good old
 				nearest lateral neighbor function.
 			*/
-			HexNode* current = hn;
+			unsigned int current = i;
 
 			unsigned int westWater = 0;
 			unsigned int eastWater = 0;
 
 			for (int j = 0; j < Settings::WaterSearchDistance; j++)
 			{
-				glm::vec3 target = RotateRelative(planetPosition, current->center, Quaternion(0.5f, 0.0f, 1.0f, 0.0f));
+				glm::vec3 target = RotateRelative(planetPosition, hexNodes.center[current], Quaternion(0.5f, 0.0f, 1.0f, 0.0f));
 
-				std::vector<HexNode> neighbors;
-				for (int k = 0; k < current->neighbors.size(); k++) neighbors.push_back(hexNodes[current->neighbors[k]]);
-
-				current = &hexNodes[FindNearestLateralNeighbor(*current, neighbors, target)];
-				if (current->biome == Biome::ocean) westWater++;
+				current = FindNearestLateralNeighbor(hexNodes, current, target);
+				if (hexNodes.biome[current] == Biome::ocean) westWater++;
 			}
 
-			current = hn;
+			current = i;
 
 			for (int j = 0; j < Settings::WaterSearchDistance; j++)
 			{
-				glm::vec3 target = RotateRelative(planetPosition, current->center, Quaternion(0.5f, 0.0f, -1.0f, 0.0f));
-
-				std::vector<HexNode> neighbors;
-				for (int k = 0; k < current->neighbors.size(); k++) neighbors.push_back(hexNodes[current->neighbors[k]]);
+				glm::vec3 target = RotateRelative(planetPosition, hexNodes.center[current], Quaternion(0.5f, 0.0f, -1.0f, 0.0f));
 
-				current = &hexNodes[FindNearestLateralNeighbor(*current, neighbors, target)];
-				if (current->biome == Biome::ocean) eastWater++;
+				current = FindNearestLateralNeighbor(hexNodes, current, target);
+				if (hexNodes.biome[current] == Biome::ocean) eastWater++;
 			}
 
-			if (eastWater >= westWater && hn->latitude < Settings::FerrelCutoff ||
-				westWater >= eastWater && hn->latitude > Settings::FerrelCutoff)
+			if (eastWater >= westWater && latitude < Settings::FerrelCutoff ||
+				westWater >= eastWater && latitude > Settings::FerrelCutoff)
 			{
-				hn->rainfall *= 1.25f;
-				hn->biome = Biome::oceanic;
+				hexNodes.rainfall[i] *= 1.25f;
+				hexNodes.biome[i] = Biome::oceanic;
 			}
 			else
 			{
-				hn->rainfall *= 0.75f;
-				hn->biome = Biome::mediterranean;
+				hexNodes.rainfall[i] *= 0.75f;
+				hexNodes.biome[i] = Biome::mediterranean;
 			}
 
-			hn->rainfall = std::max(std::min(hn->rainfall, 5000.0f), 0.0f);
+			hexNodes.rainfall[i] = std::max(std::min(hexNodes.rainfall[i], 5000.0f), 0.0f);
 		}
 
 		/*
@@ -475,39 +461,40 @@ namespace Mandalin
 			std::vector<unsigned int> newMeds;
 			std::vector<unsigned int> newOceanics;
 
-			for (int i = 0; i < hexNodes.size(); i++)
+			for (unsigned int i = 0; i < hexNodes.Size(); i++)
 			{
-				HexNode* hn = &hexNodes[i];
+				Biome biome = hexNodes.biome[i];
 
-				if (hn->biome != Biome::mediterranean &&
-					hn->biome != Biome::oceanic) continue;
+				if (biome != Biome::mediterranean &&
+					biome != Biome::oceanic) continue;
 
-				for (int j = 0; j < hn->neighbors.size(); j++)
+				for (unsigned int j = hexNodes.neighborOffsets[i]; j < hexNodes.neighborOffsets[i + 1]; j++)
 				{
-					HexNode* neighbor = &hexNodes[hn->neighbors[j]];
+					unsigned int neighbor = hexNodes.neighbors[j];
+					Biome neighborBiome = hexNodes.biome[neighbor];
 
-					if (neighbor->biome != Biome::steppe &&
-						neighbor->biome != Biome::savanna &&
-						neighbor->biome != Biome::dryforest &&
-						neighbor->biome != Biome::broadleafforest) continue;
+					if (neighborBiome != Biome::steppe &&
+						neighborBiome != Biome::savanna &&
+						neighborBiome != Biome::dryforest &&
+						neighborBiome != Biome::broadleafforest) continue;
 
-					if (hn->biome == Biome::mediterranean)
+					if (biome == Biome::mediterranean)
 					{
-						neighbor->rainfall *= Lerp(0.75f, 0.5f, iter / Settings::CoastalBiomeSpreadingIterations);
-						newMeds.push_back(hn->neighbors[j]);
+						hexNodes.rainfall[neighbor] *= Lerp(0.75f, 0.5f, iter / Settings::CoastalBiomeSpreadingIterations);
+						newMeds.push_back(neighbor);
 					}
 					else
 					{
-						neighbor->rainfall *= Lerp(1.25f, 1.0f, iter / Settings::CoastalBiomeSpreadingIterations);
-						newOceanics.push_back(hn->neighbors[j]);
+						hexNodes.rainfall[neighbor] *= Lerp(1.25f, 1.0f, iter / Settings::CoastalBiomeSpreadingIterations);
+						newOceanics.push_back(neighbor);
 					}
 
-					neighbor->rainfall = std::max(std::min(neighbor->rainfall, 5000.0f), 0.0f);
+					hexNodes.rainfall[neighbor] = std::max(std::min(hexNodes.rainfall[neighbor], 5000.0f), 0.0f);
 				}
 			}
 
-			for (int i = 0; i < newMeds.size(); i++) hexNodes[newMeds[i]].biome = Biome::mediterranean;
-			for (int i = 0; i < newOceanics.size(); i++) hexNodes[newOceanics[i]].biome = Biome::oceanic;
+			for (int i = 0; i < newMeds.size(); i++) hexNodes.biome[newMeds[i]] = Biome::mediterranean;
+			for (int i = 0; i < newOceanics.size(); i++) hexNodes.biome[newOceanics[i]] = Biome::oceanic;
 		}
 
 		/*
@@ -516,27 +503,27 @@ namespace Mandalin
 		*/
 		for (int iter = 0; iter < Settings::BiomeRoughingIterations; iter++)
 		{
-			for (int i = 0; i < hexNodes.size(); i++)
+			for (unsigned int i = 0; i < hexNodes.Size(); i++)
 			{
-				HexNode* hn = &hexNodes[i];
+				Biome biome = hexNodes.biome[i];
 
-				if (hn->biome == Biome::ocean ||
-					hn->biome == Biome::mountain ||
-					hn->biome == Biome::highlands) continue;
+				if (biome == Biome::ocean ||
+					biome == Biome::mountain ||
+					biome == Biome::highlands) continue;
 
-				int r = rand() % 100 + 1;
+				int r = rng.Range(100) + 1;
 				if (r < 80) continue;
 
-				Biome randomBiome = hexNodes[hn->neighbors[rand() % hn->neighbors.size()]].biome;
+				Biome randomBiome = hexNodes.biome[hexNodes.Neighbor(i, rng.Range(hexNodes.NeighborCount(i)))];
 
 				if (randomBiome == Biome::ocean ||
 					randomBiome == Biome::mountain ||
 					randomBiome == Biome::highlands) continue;
 
-				hn->biome = randomBiome;
+				hexNodes.biome[i] = randomBiome;
 			}
 		}
 
-		return SmoothClimate(hexNodes);
+		SmoothClimate(context);
 	}
 }
\ No newline at end of file
@@ -6,9 +6,9 @@
 namespace Mandalin
 {
 	unsigned int GetLandCarryingCapacity(Hex* hex);
-	std::vector<HexNode> SmoothClimate(std::vector<HexNode> hexNodes);
-	std::vector<HexNode> GenerateClimate(std::vector<HexNode> hexNodes, glm::vec3 planetPosition, float planetRadius);
-	std::vector<HexNode> GenerateBiomes(std::vector<HexNode> hexNodes, glm::vec3 planetPosition, float planetRadius);
+	void SmoothClimate(WorldGenContext& context);
+	void GenerateClimate(WorldGenContext& context);
+	void GenerateBiomes(WorldGenContext& context);
 }
 
 #endif
\ No newline at end of file
@@ -1,9 +1,13 @@
 #ifndef CHUNK_H
 #define CHUNK_H
 
+#include <vector>
+#include <cstdint>
+
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
+#include "../util/culling.h"
 #include "../util/settings.h"
 #include "hex.h"
 
@@ -12,26 +16,44 @@ namespace Mandalin
 	/*-------------------------------------------------*/
 	/* Vertex                                          */
 	/*-------------------------------------------------*/
+	/*
+		A vertex only knows where it is and which hex it
+		belongs to; everything else is looked up from the
+		hex's entry in the planet's per-hex buffer. The
+		top bit of the hex id marks the vertices of the
+		hex's sides.
+	*/
 	struct Vertex
 	{
+		static constexpr unsigned int	SideFlag = 0x80000000;
+
 		// Spatial Coordinates
 		float			x;
 		float			y;
 		float			z;
 
-		// Primary Color
-		float			r;
-		float			g;
-		float			b;
-		float			a;
-
-		// Rivers
-		int				river;
+		// Hex ID
+		unsigned int	hex;
+	};
 
+	/*-------------------------------------------------*/
+	/* Hex Attributes                                  */
+	/*-------------------------------------------------*/
+	/*
+		This is laid out to match the std430 struct that
+		base.vert reads out of the per-hex buffer, so be
+		careful changing it.
+	*/
+	struct HexAttributes
+	{
 		// Biome & Geology
 		int				biome;
+		int				biomeVariation;
 		int				tectonicPlate;
-		
+
+		// Rivers
+		int				river;
+
 		// Climate
 		float			temperature;
 		float			rainfall;
@@ -42,13 +64,36 @@ namespace Mandalin
 	};
 
 	/*-------------------------------------------------*/
-	/* Triangle                                        */
+	/* Draw Command                                    */
+	/*-------------------------------------------------*/
+	/*
+		One draw in an indirect buffer, laid out the way
+		glMultiDrawElementsIndirect expects to read it.
+	*/
+	struct DrawCommand
+	{
+		unsigned int	count;
+		unsigned int	instanceCount;
+		unsigned int	firstIndex;
+		int				baseVertex;
+		unsigned int	baseInstance;
+	};
+
+	/*-------------------------------------------------*/
+	/* Chunk Mesh                                      */
 	/*-------------------------------------------------*/
-	struct Triangle
+	/*
+		One of a chunk's meshes: where its vertices and
+		indices sit in the planet's lists.
+	*/
+	struct ChunkMesh
 	{
-		Vertex	a;
-		Vertex	b;
-		Vertex	c;
+		unsigned int	vertexStart;
+		unsigned int	vertexCount;
+		unsigned int	indexStart;
+		unsigned int	indexCount;
+
+		DrawCommand		Command() { return { indexCount, 1, indexStart, (int)vertexStart, 0 }; }
 	};
 
 	/*-------------------------------------------------*/
@@ -59,33 +104,52 @@ namespace Mandalin
 		tiles we send to the renderer each frame. They
 		will *only* contain the triangle data of hexes.
 
-		Given that each hex may have up to 18 associated
-		triangles (the six making up its face and the
-		twelve making up its sides, since each hex is
-		really more like a hex-shaped column extending
-		down into the planet), we need to limit the
-		number of hexes per chunk to around 100 in
-		order to avoid going over our ~1,800 triangles-
-		per-chunk (soft) limit.
-
-		Each hex will have to include its chunk, its
-		index in the chunk, and the number of triangles
-		associated with it as the 12 pentagons scattered
-		around the planet complicate any cleaner way
-		of calculating these things.
+		Each hex is really more like a hex-shaped column
+		extending down into the planet, so it can need a
+		fair few vertices for its top and sides. A chunk's
+		meshes are indexed with 16 bits, so the number of
+		hexes in a chunk (Settings::ChunkMaxHexes) is
+		capped so that a full mesh, at the worst case of
+		Settings::ChunkMaxVertsPerHex vertices per hex,
+		still fits.
+
+		A chunk's hexes are the hexCount hexes starting at
+		hexStart in the planet's flat list of hexes, and
+		each hex just keeps which chunk it's in (hexes are
+		looked up by id, not by chunk; see Planet::GetHex).
+
+		The vertices and indices themselves live in the
+		planet's lists (see ChunkMesh), which are uploaded
+		whole into one vertex buffer and one index buffer
+		shared by every chunk. Indices count from the
+		chunk's own first vertex, so drawing a chunk is
+		just a matter of pointing a draw command at its
+		range.
+
+		Each chunk has two meshes. The full one has every
+		hex's top and sides. The coarse one, for when the
+		chunk is far enough away that its hexes are only a
+		few pixels across, has no sides and just the corners
+		of each top, with each corner sitting at the average
+		height of the three hexes that meet there so that
+		the tops still close up without any sides.
 	*/
 	struct Chunk
 	{
 		unsigned int	index;
 		glm::vec3		center;
 
-		unsigned int	triCount;
+		BoundingSphere	bounds;
 
-		GLuint			vao;
-		GLuint			vbo;
+		ChunkMesh		full;
+		ChunkMesh		coarse;
 
+		unsigned int	hexStart;
 		unsigned int	hexCount;
-		Hex				hexes[Settings::ChunkMaxHexes];
+
+		// The indices of the hexes whose vertices need to
+		// be rewritten the next time the chunk is flushed.
+		std::vector<unsigned int>	dirtyHexes;
 	};
 
 }
@@ -9,6 +9,7 @@ namespace Mandalin
 	/* Focuses                                         */
 	/*-------------------------------------------------*/
 	enum class Focus { primary, biome, tectonicPlate, temperature, rainfall, population, language };
+	static constexpr unsigned int FocusCount = (unsigned int)Focus::language + 1;
 
 	/*-------------------------------------------------*/
 	/* Biomes                                          */
@@ -19,6 +20,21 @@ namespace Mandalin
 	*/
 	enum class Biome { ocean, mountain, highlands, desert, steppe, savanna, dryforest, broadleafforest, rainforest, tundra, taiga, mediterranean, oceanic };
 
+	/*-------------------------------------------------*/
+	/* Subpopulation                                   */
+	/*-------------------------------------------------*/
+	/*
+		The share of a hex's people who belong to a
+		particular population. The population is its
+		index in the history's list of populations,
+		not its id.
+	*/
+	struct Subpopulation
+	{
+		unsigned int	population;
+		double			share;
+	};
+
 	/*-------------------------------------------------*/
 	/* Hex                                             */
 	/*-------------------------------------------------*/
@@ -35,10 +51,10 @@ namespace Mandalin
 	*/
 	struct Hex
 	{
-		// Information about its chunk and its location
-		// within it.
+		// The chunk it's drawn with, and its id (which is
+		// also its place in the planet's list of hexes).
 		unsigned int											chunk;
-		unsigned int											index;
+		unsigned int											id;
 
 		// Biomes
 		Biome													biome;
@@ -58,18 +74,30 @@ namespace Mandalin
 		unsigned int											languageID;
 
 		// Variables
-		unsigned int											subpopCount;
 		std::pair<unsigned int, unsigned int>					population;			// < women, men >
 		unsigned int											Population() { return population.first + population.second; }
 		unsigned int											lcc;				// land carrying capacity
 
-		// Associated Tris
-		unsigned int											tris;
-		unsigned int											trisIndex;
+		// Every population with a share of this hex. This is
+		// the mirror image of each population's domain, so the
+		// two must always be changed together.
+		std::vector<Subpopulation>								subpopulations;
+		unsigned int											SubpopCount() { return subpopulations.size(); }
+		Subpopulation*											FindSubpopulation(unsigned int p)
+		{
+			for (int i = 0; i < subpopulations.size(); i++)
+			{
+				if (subpopulations[i].population == p) return &subpopulations[i];
+			}
+			return nullptr;
+		}
+
+		// Whether the hex is waiting in its chunk's queue
+		// to have its vertices updated.
+		bool													dirty;
 		
-		// The chunk indices of each neighbor followed by
-		// their indices within that chunk.
-		std::vector<std::pair<unsigned int, unsigned int>>		neighbors;
+		// Neighbors are kept by the planet in one shared
+		// array (see Planet::GetNeighbor).
 
 		// A multi-purpose bool that lets us know if we've
 		// already checked a hex when doing searches.
@@ -1,100 +1,290 @@
 #include "ocean.h"
 
 #include <iostream>
+#include <cmath>
+#include <utility>
 
 namespace Mandalin
 {
 	/*-----------------------------------------------*/
 	/* World Generation */
 	/*-----------------------------------------------*/
-	Ocean::Ocean(Polyhedron* polyhedron)
+	Ocean::Ocean(const Polyhedron& icosahedron, WorldSeed seed, WorkerPool& workers)
 	{
-		std::vector<Triangle> triangles;
+		radius = icosahedron.radius * Settings::OceanOffset;
 
-		float radius = polyhedron->radius * Settings::OceanOffset;
+		Polyhedron polyhedron = icosahedron;
+		for (int i = 0; i < Settings::OceanPatchLevel; i++) polyhedron.Subdivide(workers);
 
-		for (int i = 0; i < polyhedron->faces.size(); i++)
+		patchSize = 0.0f;
+
+		for (int i = 0; i < polyhedron.faces.size(); i++)
 		{
-			TriFace* tf = &polyhedron->faces[i];
+			TriFace* tf = &polyhedron.faces[i];
 
-			glm::vec3 a = radius * glm::normalize(polyhedron->vertices[tf->a].vertex);
-			glm::vec3 b = radius * glm::normalize(polyhedron->vertices[tf->b].vertex);
-			glm::vec3 c = radius * glm::normalize(polyhedron->vertices[tf->c].vertex);
+			OceanPatch patch = {};
+			patch.a = glm::normalize(polyhedron.vertices[tf->a].vertex);
+			patch.b = glm::normalize(polyhedron.vertices[tf->b].vertex);
+			patch.c = glm::normalize(polyhedron.vertices[tf->c].vertex);
 
-			glm::vec4 color = Settings::OceanColor;
+			// Wind every patch counterclockwise seen from outside.
+			if (glm::dot(glm::cross(patch.b - patch.a, patch.c - patch.a), patch.a + patch.b + patch.c) < 0.0f) std::swap(patch.b, patch.c);
 
-			Triangle tri =
-			{
-				{ a.x, a.y, a.z, color.r, color.g, color.b, color.a, 0.0f, 0.0f, 0.0f },
-				{ b.x, b.y, b.z, color.r, color.g, color.b, color.a, 0.0f, 0.0f, 0.0f },
-				{ c.x, c.y, c.z, color.r, color.g, color.b, color.a, 0.0f, 0.0f, 0.0f }
-			};
+			patchSize += (glm::distance(patch.a, patch.b) + glm::distance(patch.b, patch.c) + glm::distance(patch.c, patch.a)) / 3.0f;
 
-			triangles.push_back(tri);
+			patches.push_back(patch);
 		}
 
-		std::cout << "Generating an ocean with " << triangles.size() << " triangles." << std::endl;
+		patchSize = radius * patchSize / patches.size();
+
+		GenerateMeshes();
+		GenerateNoise(seed);
+
+		std::cout << "Generating an ocean with " << patches.size() << " patches." << std::endl;
+	}
 
-		for (int i = 0; i < triangles.size(); i += Settings::OceanChunkMaxTris)
+	void Ocean::GenerateMeshes()
+	{
+		/*
+			Each mesh is a triangle cut into n segments along
+			each edge. Vertex (i, j) sits i segments toward the
+			second corner and j toward the third, and the rows
+			(of equal j) go one after another.
+		*/
+		for (unsigned int n = 1; n <= Settings::OceanMaxSegments; n *= 2)
 		{
-			unsigned int allotedTris = std::min(Settings::OceanChunkMaxTris, (unsigned int)triangles.size() - i);
+			ChunkMesh mesh;
+			mesh.vertexStart = vertices.size();
+			mesh.indexStart = indices.size();
 
-			chunks.push_back({});
-			OceanChunk* c = &chunks[chunks.size() - 1];
+			std::vector<unsigned int> rowStarts;
 
-			c->index = chunks.size() - 1;
-			c->triCount = allotedTris;
+			for (unsigned int j = 0; j <= n; j++)
+			{
+				rowStarts.push_back(vertices.size() - mesh.vertexStart);
+				for (unsigned int i = 0; i <= n - j; i++) vertices.push_back({ i / (float)n, j / (float)n, 0.0f });
+			}
 
-			c->center = glm::vec3(0.0f, 0.0f, 0.0f);
-			for (int j = i; j < i + allotedTris; j++)
+			auto at = [&](unsigned int i, unsigned int j) { return (uint16_t)(rowStarts[j] + i); };
+
+			for (unsigned int j = 0; j < n; j++)
 			{
-				Triangle* t = &triangles[j];
-				glm::vec3 ta = { t->a.x, t->a.y, t->a.z };
-				glm::vec3 tb = { t->b.x, t->b.y, t->b.z };
-				glm::vec3 tc = { t->c.x, t->c.y, t->c.z };
-				glm::vec3 td = (ta + tb + tc) / 3.0f;
+				for (unsigned int i = 0; i < n - j; i++)
+				{
+					indices.push_back(at(i, j));
+					indices.push_back(at(i + 1, j));
+					indices.push_back(at(i, j + 1));
 
-				c->center = td;
+					if (i + 1 < n - j)
+					{
+						indices.push_back(at(i + 1, j));
+						indices.push_back(at(i + 1, j + 1));
+						indices.push_back(at(i, j + 1));
+					}
+				}
 			}
-			c->center /= allotedTris;
-			c->center = radius * glm::normalize(c->center);
 
-			GLuint IBO;
+			/*
+				Then the skirt, which runs around the three edges
+				(first to second corner, second to third, third
+				back to the first), dropping a copy of each edge
+				vertex down beneath it.
+			*/
+			for (int edge = 0; edge < 3; edge++)
+			{
+				uint16_t first = vertices.size() - mesh.vertexStart;
 
-			glGenVertexArrays(1, &c->vao);
-			glBindVertexArray(c->vao);
+				for (unsigned int k = 0; k <= n; k++)
+				{
+					unsigned int i = (edge == 0) ? k : ((edge == 1) ? n - k : 0);
+					unsigned int j = (edge == 0) ? 0 : ((edge == 1) ? k : n - k);
 
-			glGenBuffers(1, &c->vbo);
-			glBindBuffer(GL_ARRAY_BUFFER, c->vbo);
+					vertices.push_back({ i / (float)n, j / (float)n, 1.0f });
+				}
 
-			glGenBuffers(1, &IBO);
-			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, IBO);
+				for (unsigned int k = 0; k < n; k++)
+				{
+					unsigned int i = (edge == 0) ? k : ((edge == 1) ? n - k : 0);
+					unsigned int j = (edge == 0) ? 0 : ((edge == 1) ? k : n - k);
+					unsigned int nextI = (edge == 0) ? k + 1 : ((edge == 1) ? n - k - 1 : 0);
+					unsigned int nextJ = (edge == 0) ? 0 : ((edge == 1) ? k + 1 : n - k - 1);
 
-			glBufferData(GL_ARRAY_BUFFER, c->triCount * sizeof(Triangle), &triangles[i], GL_DYNAMIC_DRAW);
+					indices.push_back(at(i, j));
+					indices.push_back(at(nextI, nextJ));
+					indices.push_back(first + k + 1);
 
-			// Coordinates
-			glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, x));
-			glEnableVertexAttribArray(0);
+					indices.push_back(at(i, j));
+					indices.push_back(first + k + 1);
+					indices.push_back(first + k);
+				}
+			}
 
-			// Color
-			glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, r));
-			glEnableVertexAttribArray(1);
+			mesh.vertexCount = vertices.size() - mesh.vertexStart;
+			mesh.indexCount = indices.size() - mesh.indexStart;
+			meshes.push_back(mesh);
+		}
+	}
+
+	void Ocean::GenerateNoise(WorldSeed seed)
+	{
+		/*
+			A few octaves of value noise, each on a coarser grid
+			of random values than the next and smoothly blended
+			between them. Every grid wraps around at its edges,
+			so the texture tiles.
+		*/
+		Random rng = seed.Stream(SeedStage::ocean);
 
-			unsigned int indices[Settings::OceanChunkMaxTris * 3];
-			for (int i = 0; i < Settings::OceanChunkMaxTris; i++)
+		unsigned int size = Settings::OceanNoiseSize;
+		std::vector<float> total(size * size, 0.0f);
+
+		float amplitude = 1.0f;
+		float amplitudes = 0.0f;
+
+		for (unsigned int cells = 4; cells <= size / 8; cells *= 2)
+		{
+			std::vector<float> lattice(cells * cells);
+			for (int i = 0; i < lattice.size(); i++) lattice[i] = (float)rng.Uniform();
+
+			for (unsigned int y = 0; y < size; y++)
 			{
-				const int offset = 3 * i;
+				for (unsigned int x = 0; x < size; x++)
+				{
+					float fx = x * cells / (float)size;
+					float fy = y * cells / (float)size;
+
+					unsigned int x0 = (unsigned int)fx;
+					unsigned int y0 = (unsigned int)fy;
+					unsigned int x1 = (x0 + 1) % cells;
+					unsigned int y1 = (y0 + 1) % cells;
+
+					float tx = fx - x0;
+					float ty = fy - y0;
+					tx = tx * tx * (3.0f - 2.0f * tx);
+					ty = ty * ty * (3.0f - 2.0f * ty);
+
+					float top = Lerp(lattice[y0 * cells + x0], lattice[y0 * cells + x1], tx);
+					float bottom = Lerp(lattice[y1 * cells + x0], lattice[y1 * cells + x1], tx);
 
-				indices[offset + 0] = offset + 0;
-				indices[offset + 1] = offset + 1;
-				indices[offset + 2] = offset + 2;
+					total[y * size + x] += amplitude * Lerp(top, bottom, ty);
+				}
 			}
 
-			glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+			amplitudes += amplitude;
+			amplitude /= 2.0f;
+		}
+
+		noise.resize(size * size);
+		for (int i = 0; i < noise.size(); i++) noise[i] = (unsigned char)(255.0f * total[i] / amplitudes);
+	}
+
+	void Ocean::BuildBounds(glm::vec3 occluderCenter, float occluderRadius)
+	{
+		/*
+			The bounds have to hold each patch however finely
+			it's drawn, wherever its waves are, and all the way
+			down its skirt, so we go by the finest mesh's
+			vertices at both the highest and lowest they can
+			reach.
+
+			The normal cones only go by the surface. A skirt is
+			only ever seen through a crack beside its patch, so
+			once the patch faces away, so does anything its
+			skirt would be covering.
+		*/
+		patchBounds.Clear();
+
+		ChunkMesh* finest = &meshes.back();
 
-			glBindVertexArray(0);
-			glBindBuffer(GL_ARRAY_BUFFER, 0);
-			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+		for (int i = 0; i < patches.size(); i++)
+		{
+			OceanPatch* p = &patches[i];
+
+			std::vector<glm::vec3> points;
+			std::vector<glm::vec3> normals;
+
+			for (unsigned int j = finest->vertexStart; j < finest->vertexStart + finest->vertexCount; j++)
+			{
+				OceanVertex* v = &vertices[j];
+				glm::vec3 direction = glm::normalize(p->a * (1.0f - v->u - v->v) + p->b * v->u + p->c * v->v);
+
+				points.push_back(occluderCenter + direction * (radius + Settings::OceanWaveHeight));
+				points.push_back(occluderCenter + direction * (radius - Settings::OceanSkirtDepth));
+				normals.push_back(direction);
+			}
+
+			p->bounds = BuildBoundingSphere(points);
+			patchBounds.Add(p->bounds, BuildNormalCone(p->a + p->b + p->c, normals), BuildHorizonPoint(points, occluderCenter, occluderRadius));
+		}
+	}
+
+	/*-----------------------------------------------*/
+	/* Geometry */
+	/*-----------------------------------------------*/
+	void Ocean::LoadGeometry()
+	{
+		if (geometryLoaded) return;
+
+		glGenVertexArrays(1, &vao);
+		glBindVertexArray(vao);
+
+		glGenBuffers(1, &vbo);
+		glBindBuffer(GL_ARRAY_BUFFER, vbo);
+		glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(OceanVertex), vertices.data(), GL_STATIC_DRAW);
+
+		glGenBuffers(1, &ibo);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint16_t), indices.data(), GL_STATIC_DRAW);
+
+		// Patch Coordinates
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(OceanVertex), (void*)offsetof(OceanVertex, u));
+		glEnableVertexAttribArray(0);
+
+		// Patch Corners (one set per instance, filled in by
+		// the renderer each frame)
+		glGenBuffers(1, &instanceBuffer);
+		glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+		glBufferData(GL_ARRAY_BUFFER, patches.size() * sizeof(OceanInstance), nullptr, GL_STREAM_DRAW);
+
+		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(OceanInstance), (void*)offsetof(OceanInstance, ax));
+		glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(OceanInstance), (void*)offsetof(OceanInstance, bx));
+		glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(OceanInstance), (void*)offsetof(OceanInstance, cx));
+
+		for (int i = 1; i <= 3; i++)
+		{
+			glEnableVertexAttribArray(i);
+			glVertexAttribDivisor(i, 1);
 		}
+
+		glBindVertexArray(0);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+		// Noise
+		glGenTextures(1, &noiseTexture);
+		glBindTexture(GL_TEXTURE_2D, noiseTexture);
+
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, Settings::OceanNoiseSize, Settings::OceanNoiseSize, 0, GL_RED, GL_UNSIGNED_BYTE, noise.data());
+
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		// The ocean never changes once it is on the GPU,
+		// so there's no reason to hold onto these. (The
+		// patches stay, since the renderer needs their
+		// corners.)
+		vertices.clear();
+		vertices.shrink_to_fit();
+		indices.clear();
+		indices.shrink_to_fit();
+		noise.clear();
+		noise.shrink_to_fit();
+
+		geometryLoaded = true;
 	}
-}
\ No newline at end of file
+}
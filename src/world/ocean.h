@@ -2,41 +2,145 @@
 #define OCEAN_H
 
 #include "chunk.h"
+#include "../util/culling.h"
 #include "../util/geometry.h"
+#include "../util/random.h"
 
 namespace Mandalin
 {
-	struct OceanChunk
+	/*-------------------------------------------------*/
+	/* Ocean Vertex                                    */
+	/*-------------------------------------------------*/
+	/*
+		The ocean is a sphere, so a vertex doesn't need to
+		know anything but where it sits on its patch: how
+		far it is toward the patch's second and third
+		corners, and whether it belongs to the patch's
+		skirt (see Ocean below). The vertex shader puts it
+		on the sphere from there.
+	*/
+	struct OceanVertex
 	{
-		unsigned int	index;
-		glm::vec3		center;
+		float			u;
+		float			v;
+		float			skirt;
+	};
 
-		unsigned int	triCount;
+	/*-------------------------------------------------*/
+	/* Ocean Patch                                     */
+	/*-------------------------------------------------*/
+	/*
+		One face of a lightly subdivided icosahedron, with
+		its corners as directions from the planet's center.
+	*/
+	struct OceanPatch
+	{
+		glm::vec3		a;
+		glm::vec3		b;
+		glm::vec3		c;
 
-		GLuint			vao;
-		GLuint			vbo;
+		BoundingSphere	bounds;
+	};
+
+	/*
+		What the renderer hands over for each patch it draws,
+		laid out for the per-instance attributes of the
+		ocean's vertex array.
+	*/
+	struct OceanInstance
+	{
+		float			ax, ay, az;
+		float			bx, by, bz;
+		float			cx, cy, cz;
 	};
 
+	/*-------------------------------------------------*/
+	/* Ocean                                           */
+	/*-------------------------------------------------*/
+	/*
+		Every patch is drawn from the same handful of
+		meshes, each a triangle cut into a grid with a
+		different number of segments along its edges (1,
+		2, 4, and so on up to Settings::OceanMaxSegments),
+		so the renderer can pick how finely to draw each
+		patch by how big it is on screen.
+
+		Where two patches drawn at different detail meet,
+		the finer one has vertices along the edge that the
+		coarser one doesn't, which leaves thin cracks. Each
+		mesh has a skirt hanging down from its edges to
+		cover them.
+	*/
 	class Ocean
 	{
 	private:
 		/*-----------------------------------------------*/
-		/* Chunks */
+		/* Patches */
+		/*-----------------------------------------------*/
+		float						radius;
+		std::vector<OceanPatch>		patches;
+		CullBatch					patchBounds;
+
+		// The average length of a patch's edge.
+		float						patchSize;
+
+		/*-----------------------------------------------*/
+		/* Geometry */
 		/*-----------------------------------------------*/
-		std::vector<OceanChunk>		chunks;
+		std::vector<OceanVertex>	vertices;
+		std::vector<uint16_t>		indices;
+		std::vector<ChunkMesh>		meshes;
+
+		/*
+			A tiling noise texture which the waves are read out
+			of, rather than working out noise for every vertex
+			of the ocean every frame.
+		*/
+		std::vector<unsigned char>	noise;
+
+		bool						geometryLoaded = false;
+
+		GLuint						vao = 0;
+		GLuint						vbo = 0;
+		GLuint						ibo = 0;
+		GLuint						instanceBuffer = 0;
+		GLuint						noiseTexture = 0;
+
+		void						GenerateMeshes();
+		void						GenerateNoise(WorldSeed seed);
 
 	public:
 		/*-----------------------------------------------*/
-		/* Chunks, Cont. */
+		/* Patches, Cont. */
 		/*-----------------------------------------------*/
-		unsigned int				ChunkCount() { return chunks.size(); }
-		OceanChunk*					GetChunk(unsigned int i) { return &chunks[i]; }
+		float						GetRadius() { return radius; }
+		unsigned int				PatchCount() { return patches.size(); }
+		OceanPatch*					GetPatch(unsigned int i) { return &patches[i]; }
+		const CullBatch&			GetPatchBounds() { return patchBounds; }
+		float						GetPatchSize() { return patchSize; }
+
+		/*-----------------------------------------------*/
+		/* Geometry, Cont. */
+		/*-----------------------------------------------*/
+		// Mesh i has 2^i segments along each edge.
+		unsigned int				MeshCount() { return meshes.size(); }
+		ChunkMesh*					GetMesh(unsigned int i) { return &meshes[i]; }
+
+		bool						GeometryLoaded() { return geometryLoaded; }
+		GLuint						GetVAO() { return vao; }
+		GLuint						GetInstanceBuffer() { return instanceBuffer; }
+		GLuint						GetNoiseTexture() { return noiseTexture; }
+		void						LoadGeometry();
 
 		/*-----------------------------------------------*/
 		/* World Generation */
 		/*-----------------------------------------------*/
-		Ocean(Polyhedron* polyhedron);
+		// Has to wait until the planet knows its occluder.
+		void						BuildBounds(glm::vec3 occluderCenter, float occluderRadius);
+
+		// Takes the icosahedron before it's been subdivided.
+		Ocean(const Polyhedron& icosahedron, WorldSeed seed, WorkerPool& workers);
 	};
 }
 
-#endif
\ No newline at end of file
+#endif
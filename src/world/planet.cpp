@@ -1,6 +1,6 @@
 #include "planet.h"
 
-#include <time.h>
+#include <cstring>
 #include <iostream>
 #include <algorithm>
 
@@ -9,66 +9,85 @@ namespace Mandalin
 	/*-----------------------------------------------*/
 	/* Utility */
 	/*-----------------------------------------------*/
-	Hex* Planet::GetHex(unsigned int chunk, unsigned int index)
+	Hex* Planet::GetHex(HexCoord coord)
 	{
-		if (chunk > chunks.size() || index > Settings::ChunkMaxHexes) return nullptr;
-		return &chunks[chunk].hexes[index];
+		unsigned int id = grid->Id(coord);
+		if (id == HexGrid::NoHex) return nullptr;
+		return &hexes[id];
 	}
 
-	void Planet::SetPopulation(unsigned int chunk, unsigned int hex, int population)
+	// Finds the hex under a point in world space.
+	Hex* Planet::LocateHex(glm::vec3 point)
 	{
-		Chunk* c = &chunks[chunk];
-		Hex* h = &c->hexes[hex];
+		return GetHex(grid->Locate(point - position));
+	}
 
-		h->populationID = population;
+	void Planet::MarkDirty(Hex* h)
+	{
+		if (!geometryLoaded || h->dirty) return;
 
-		glBindVertexArray(c->vao);
-		glBindBuffer(GL_ARRAY_BUFFER, c->vbo);
+		Chunk* c = &chunks[h->chunk];
 
-		int triStart = h->trisIndex * sizeof(Triangle);
-		int popOffset = offsetof(Vertex, population);
+		h->dirty = true;
+		c->dirtyHexes.push_back(h->id - c->hexStart);
+	}
 
-		for (int i = 0; i < h->tris; i++)
-		{
-			int triOffset = i * sizeof(Triangle);
+	void Planet::SetPopulation(unsigned int hex, int population)
+	{
+		Hex* h = &hexes[hex];
 
-			for (int j = 0; j < 3; j++)
-			{
-				int vertOffset = j * sizeof(Vertex);
-				glBufferSubData(GL_ARRAY_BUFFER, triStart + triOffset + vertOffset + popOffset, sizeof(int), &population);
-			}
-		}
+		if (h->populationID == population) return;
 
-		glBindVertexArray(0);
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		h->populationID = population;
+		hexAttributes[hex].population = population;
+		MarkDirty(h);
 	}
 
-	void Planet::SetLanguage(unsigned int chunk, unsigned int hex, int language)
+	void Planet::SetLanguage(unsigned int hex, int language)
 	{
-		Chunk* c = &chunks[chunk];
-		Hex* h = &c->hexes[hex];
+		Hex* h = &hexes[hex];
 
-		h->languageID = language;
+		if (h->languageID == language) return;
 
-		glBindVertexArray(c->vao);
-		glBindBuffer(GL_ARRAY_BUFFER, c->vbo);
+		h->languageID = language;
+		hexAttributes[hex].language = language;
+		MarkDirty(h);
+	}
 
-		int triStart = h->trisIndex * sizeof(Triangle);
-		int langOffset = offsetof(Vertex, language);
+	void Planet::FlushChunks()
+	{
+		/*
+			Rather than poking at the hex buffer every time the
+			simulation changes a hex, we wait until the frame is
+			drawn and then write the range of each chunk's hexes
+			that were touched in one go.
+		*/
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, hexBuffer);
 
-		for (int i = 0; i < h->tris; i++)
+		for (int i = 0; i < chunks.size(); i++)
 		{
-			int triOffset = i * sizeof(Triangle);
+			Chunk* c = &chunks[i];
+
+			if (c->dirtyHexes.empty()) continue;
 
-			for (int j = 0; j < 3; j++)
+			unsigned int first = c->hexCount;
+			unsigned int last = 0;
+
+			for (int j = 0; j < c->dirtyHexes.size(); j++)
 			{
-				int vertOffset = j * sizeof(Vertex);
-				glBufferSubData(GL_ARRAY_BUFFER, triStart + triOffset + vertOffset + langOffset, sizeof(int), &language);
+				first = std::min(first, c->dirtyHexes[j]);
+				last = std::max(last, c->dirtyHexes[j] + 1);
+
+				hexes[c->hexStart + c->dirtyHexes[j]].dirty = false;
 			}
+
+			unsigned int start = c->hexStart + first;
+			glBufferSubData(GL_SHADER_STORAGE_BUFFER, start * sizeof(HexAttributes), (last - first) * sizeof(HexAttributes), &hexAttributes[start]);
+
+			c->dirtyHexes.clear();
 		}
 
-		glBindVertexArray(0);
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
 	}
 
 	/*-----------------------------------------------*/
@@ -83,7 +102,50 @@ namespace Mandalin
 		return 0.5f * (3.0f / worldSize);
 	}
 
-	std::vector<HexNode> Planet::Hexify(Polyhedron* polyhedron)
+#ifndef NDEBUG
+	/*
+		The old greedy sort walked from each neighbor to the
+		nearest one it hadn't visited yet, so what it handed
+		back was a ring where each neighbor touches the next.
+		A hex's neighbors only form one such ring, so if ours
+		has the same property (and turns the right way) then
+		it's the same ordering, give or take where it starts.
+	*/
+	static void ValidateNeighborOrder(const HexNodes& hexNodes)
+	{
+		unsigned int bad = 0;
+
+		for (unsigned int i = 0; i < hexNodes.Size(); i++)
+		{
+			unsigned int count = hexNodes.NeighborCount(i);
+			glm::vec3 center = hexNodes.center[i];
+
+			for (unsigned int j = 0; j < count; j++)
+			{
+				unsigned int a = hexNodes.Neighbor(i, j);
+				unsigned int b = hexNodes.Neighbor(i, (j + 1) % count);
+
+				bool touching = false;
+				for (unsigned int k = 0; k < hexNodes.NeighborCount(a); k++)
+				{
+					if (hexNodes.Neighbor(a, k) == b) touching = true;
+				}
+
+				glm::vec3 turn = glm::cross(hexNodes.center[a] - center, hexNodes.center[b] - center);
+
+				if (!touching || glm::dot(turn, center) <= 0.0f)
+				{
+					bad++;
+					break;
+				}
+			}
+		}
+
+		if (bad != 0) std::cout << "Found " << bad << " hexes with out of order neighbors." << std::endl;
+	}
+#endif
+
+	void Planet::Hexify(Polyhedron* polyhedron, WorldGenContext& context)
 	{
 		/*
 			First, we have to turn our polyhedron into hexes.
@@ -118,230 +180,133 @@ namespace Mandalin
 			shouldn't be too bad.
 		*/
 
-		std::vector<HexNode> hexNodes;
+		HexNodes& hexNodes = context.nodes;
+
+		unsigned int vertexCount = polyhedron->vertices.size();
+		unsigned int faceCount = polyhedron->faces.size();
 
 		/*
-			First, we go through each vertex.
+			Every vertex hex has one neighbor for each triangle
+			sharing its vertex, and every face hex has six, so we
+			know where each hex's neighbors go in the neighbor
+			array before finding any of them. That leaves each
+			hex to be worked out entirely on its own.
 		*/
-		for (int i = 0; i < polyhedron->vertices.size(); i++)
-		{
-			PolyVert* pv = &polyhedron->vertices[i];
+		hexNodes.Clear();
+		hexNodes.Resize(vertexCount + faceCount);
 
-			/*
-				We need to find all the vertices of the triangles
-				which share this vertex.
-			*/
-			std::vector<unsigned int> neighborIndices;
-
-			for (int j = 0; j < pv->sharers.size(); j++)
-			{
-				unsigned int ind = pv->sharers[j];
-				ind += polyhedron->vertices.size();
-				neighborIndices.push_back(ind);
-			}
+		hexNodes.neighborOffsets.resize(vertexCount + faceCount + 1);
+		hexNodes.neighborOffsets[0] = 0;
 
-			HexNode hn =
-			{
-				i,
-				pv->vertex,
-				neighborIndices
-			};
+		for (unsigned int i = 0; i < vertexCount; i++)
+		{
+			hexNodes.neighborOffsets[i + 1] = hexNodes.neighborOffsets[i] + polyhedron->Valence(i);
+		}
 
-			hexNodes.push_back(hn);
+		for (unsigned int i = 0; i < faceCount; i++)
+		{
+			hexNodes.neighborOffsets[vertexCount + i + 1] = hexNodes.neighborOffsets[vertexCount + i] + 6;
 		}
 
+		hexNodes.neighbors.resize(hexNodes.neighborOffsets.back());
+
 		/*
-			Now, we go through each face.
+			The centers don't depend on anything else, so they
+			can all go at once.
 		*/
-		for (int i = 0; i < polyhedron->faces.size(); i++)
+		context.workers.ParallelFor(vertexCount + faceCount, [&](unsigned int i)
 		{
-			TriFace* tf = &polyhedron->faces[i];
-
-			/*
-				Each hex derived from a face has six neighbors:
-
-					3 derived from vertices
-					3 derived from triangles
-
-				Those derived from vertices come from the three
-				vertices that make up the triangle, while the
-				three derived from triangles come from the neighbors
-				that share two vertices with the triangle.
-
-				Since the former are easier, we can do those first.
-			*/
-
-			std::vector<unsigned int> neighborIndices;
-
-			neighborIndices.push_back(tf->a);
-			neighborIndices.push_back(tf->b);
-			neighborIndices.push_back(tf->c);
-
-			/*
-				Now, we must go through and find the neighboring
-				triangles that share two vertices with this one.
-
-				We're going to do this in pairs. First all the
-				sharers of vertex A, checking if they have B,
-				then all the sharers of vertex B, checking if
-				they have C, then all the sharers of vertex C,
-				checking if they have A.
-			*/
-
-			// At A Checking B
-			PolyVert* tfA = &polyhedron->vertices[tf->a];
-			for (int j = 0; j < tfA->sharers.size(); j++)
-			{
-				TriFace* tf2 = &polyhedron->faces[tfA->sharers[j]];
-
-				if (tf == tf2) continue;
-
-				if (tf2->a == tf->b ||
-					tf2->b == tf->b ||
-					tf2->c == tf->b)
-				{
-					neighborIndices.push_back(polyhedron->vertices.size() + tfA->sharers[j]);
-					break;
-				}
-			}
-
-			// At B Checking C
-			PolyVert* tfB = &polyhedron->vertices[tf->b];
-			for (int j = 0; j < tfB->sharers.size(); j++)
+			if (i < vertexCount)
 			{
-				TriFace* tf2 = &polyhedron->faces[tfB->sharers[j]];
-
-				if (tf == tf2) continue;
-
-				if (tf2->a == tf->c ||
-					tf2->b == tf->c ||
-					tf2->c == tf->c)
-				{
-					neighborIndices.push_back(polyhedron->vertices.size() + tfB->sharers[j]);
-					break;
-				}
+				hexNodes.center[i] = polyhedron->vertices[i].vertex;
+				return;
 			}
 
-			// At C Checking A
-			PolyVert* tfC = &polyhedron->vertices[tf->c];
-			for (int j = 0; j < tfC->sharers.size(); j++)
-			{
-				TriFace* tf2 = &polyhedron->faces[tfC->sharers[j]];
-
-				if (tf == tf2) continue;
-
-				if (tf2->a == tf->a ||
-					tf2->b == tf->a ||
-					tf2->c == tf->a)
-				{
-					neighborIndices.push_back(polyhedron->vertices.size() + tfC->sharers[j]);
-					break;
-				}
-			}
+			TriFace* tf = &polyhedron->faces[i - vertexCount];
 
 			glm::vec3 center = polyhedron->vertices[tf->a].vertex;
 			center += polyhedron->vertices[tf->b].vertex;
 			center += polyhedron->vertices[tf->c].vertex;
-			center = polyhedron->radius * glm::normalize(center / 3.0f);
+			hexNodes.center[i] = polyhedron->radius * glm::normalize(center / 3.0f);
+		});
 
-			HexNode hn =
-			{
-				i + polyhedron->vertices.size(),
-				center,
-				neighborIndices
-			};
-
-			hexNodes.push_back(hn);
-		}
-
-		std::cout << "Generated " << hexNodes.size() << " hexes." << std::endl;
-		return hexNodes;
-	}
-
-	std::vector<HexNode> Planet::SortNeighbors(std::vector<HexNode> hexNodes)
-	{
 		/*
-			Now, we need to go through and sort each hex's neighbors.
-
+			Now the neighbors, which we want to go around each hex
+			in order (counter-clockwise, looking down on the planet)
+			so that the geometry can walk straight around them.
+
+			Walking the polyhedron's edges takes us around every
+			hex in the direction its faces are wound. All the faces
+			are wound the same way, so one check tells us whether
+			that's the way we want or whether every ring needs
+			flipping.
 		*/
-		for (int i = 0; i < hexNodes.size(); i++)
-		{
-			HexNode* hn = &hexNodes[i];
+		TriFace* first = &polyhedron->faces[0];
+		glm::vec3 fa = polyhedron->vertices[first->a].vertex;
+		glm::vec3 fb = polyhedron->vertices[first->b].vertex;
+		glm::vec3 fc = polyhedron->vertices[first->c].vertex;
+		bool clockwise = glm::dot(glm::cross(fb - fa, fc - fa), fa + fb + fc) < 0.0f;
 
-			unsigned int currentNeighborIdx = hn->neighbors[0];
-			std::vector<unsigned int> sortedNeighbors = { currentNeighborIdx };
+		context.workers.ParallelFor(vertexCount + faceCount, [&](unsigned int i)
+		{
+			unsigned int* neighbors = hexNodes.Neighbors(i);
+			unsigned int count = hexNodes.NeighborCount(i);
 
-			// Now, we iterate through all the neighbors.
-			while (true)
+			if (i < vertexCount)
 			{
-				// And we see what the nearest neighbor is which hasn't already
-				// been added to sortedNeighbors.
-				glm::vec3 a = hexNodes[currentNeighborIdx].center;
-
-				unsigned int nearestNeighbor;
-				float nearestDistance = INFINITY;
-
-				for (int j = 0; j < hn->neighbors.size(); j++)
+				/*
+					The neighbors of a vertex hex are the triangles
+					around it, which we get by turning from one edge
+					leaving the vertex to the next.
+				*/
+				unsigned int e = polyhedron->vertices[i].edge;
+
+				for (unsigned int j = 0; j < count; j++)
 				{
-					bool alreadyIncluded = false;
-
-					for (int k = 0; k < sortedNeighbors.size(); k++)
-					{
-						if (sortedNeighbors[k] == hn->neighbors[j]) alreadyIncluded = true;
-					}
-
-					if (alreadyIncluded) continue;
-
-					glm::vec3 b = hexNodes[hn->neighbors[j]].center;
-
-					float dist = glm::distance(a, b);
-
-					if (dist < nearestDistance)
-					{
-						nearestDistance = dist;
-						nearestNeighbor = hn->neighbors[j];
-					}
+					neighbors[j] = vertexCount + Polyhedron::EdgeFace(e);
+					e = polyhedron->NextAround(e);
 				}
-
-				if (nearestDistance == INFINITY) break;
-				sortedNeighbors.push_back(nearestNeighbor);
-				currentNeighborIdx = nearestNeighbor;
 			}
-
-			hn->neighbors = sortedNeighbors;
-		}
-
-		std::vector<std::pair<unsigned int, unsigned int>> oldIndices;
-		for (int i = 0; i < hexNodes.size(); i++)
-		{
-			oldIndices.push_back(std::pair<unsigned int, unsigned int>(hexNodes[i].index, 0));
-		}
-
-		hexNodes = VoronoiSort(hexNodes);
-
-		for (int i = 0; i < hexNodes.size(); i++)
-		{
-			oldIndices[hexNodes[i].index].second = i;
-		}
-
-		for (int i = 0; i < hexNodes.size(); i++)
-		{
-			for (int j = 0; j < hexNodes[i].neighbors.size(); j++)
+			else
 			{
-				hexNodes[i].neighbors[j] = oldIndices[hexNodes[i].neighbors[j]].second;
+				/*
+					Each hex derived from a face has six neighbors:
+
+						3 derived from vertices
+						3 derived from triangles
+
+					The three derived from vertices are the vertices
+					themselves; the three derived from triangles are
+					the ones on the other side of each edge's twin.
+					Going a, (across ab), b, (across bc), c, (across ca)
+					follows the face's winding.
+				*/
+				unsigned int face = i - vertexCount;
+				TriFace* tf = &polyhedron->faces[face];
+
+				neighbors[0] = tf->a;
+				neighbors[1] = vertexCount + Polyhedron::EdgeFace(polyhedron->twins[3 * face]);
+				neighbors[2] = tf->b;
+				neighbors[3] = vertexCount + Polyhedron::EdgeFace(polyhedron->twins[3 * face + 1]);
+				neighbors[4] = tf->c;
+				neighbors[5] = vertexCount + Polyhedron::EdgeFace(polyhedron->twins[3 * face + 2]);
 			}
-		}
 
-		for (int i = 0; i < hexNodes.size(); i++)
-		{
-			hexNodes[i].index = i;
-		}
+			if (clockwise) std::reverse(neighbors, neighbors + count);
+		});
 
-		return hexNodes;
+#ifndef NDEBUG
+		ValidateNeighborOrder(hexNodes);
+#endif
+
+		std::cout << "Generated " << hexNodes.Size() << " hexes." << std::endl;
 	}
 
-	std::vector<HexNode> Planet::GenerateTopology(std::vector<HexNode> hexNodes)
+	void Planet::GenerateTopology(WorldGenContext& context)
 	{
+		HexNodes& hexNodes = context.nodes;
+		Random rng = context.seed.Stream(SeedStage::topology);
+
 		/*
 			Now, we go through and find the biome of each
 			area.
@@ -354,7 +319,7 @@ namespace Mandalin
 
 		for (int i = 0; i < Settings::ContinentCount; i++)
 		{
-			oceans.push_back((rand() % 100) + 1);
+			oceans.push_back(rng.Range(100) + 1);
 		}
 
 		/*
@@ -365,39 +330,38 @@ namespace Mandalin
 
 			We can also take this moment to set all the faults.
 		*/
-		for (int i = 0; i < hexNodes.size(); i++)
+		for (unsigned int i = 0; i < hexNodes.Size(); i++)
 		{
-			HexNode* hn = &hexNodes[i];
-			hn->ocean = (oceans[hn->continent] > 50);
+			hexNodes.Set(i, NodeFlag::ocean, oceans[hexNodes.continent[i]] > 50);
 		}
 
 		for (int iter = 0; iter < Settings::CoastRoughingIterations; iter++)
 		{
-			for (int i = 0; i < hexNodes.size(); i++)
+			for (unsigned int i = 0; i < hexNodes.Size(); i++)
 			{
-				HexNode* hn = &hexNodes[i];
-
 				// Now we see how many ocean and land
 				// neighbors this node has.
 				int oceanNeighbors = 0;
 				int landNeighbors = 0;
 				int nonPlateNeighbors = 0;
 
-				for (int j = 0; j < hn->neighbors.size(); j++)
+				for (unsigned int j = hexNodes.neighborOffsets[i]; j < hexNodes.neighborOffsets[i + 1]; j++)
 				{
-					HexNode* neighbor = &hexNodes[hn->neighbors[j]];
+					unsigned int neighbor = hexNodes.neighbors[j];
 
-					if (neighbor->ocean) oceanNeighbors++;
+					if (hexNodes.Has(neighbor, NodeFlag::ocean)) oceanNeighbors++;
 					else landNeighbors++;
 
-					if (hn->tectonicPlate != neighbor->tectonicPlate) nonPlateNeighbors++;
+					if (hexNodes.tectonicPlate[i] != hexNodes.tectonicPlate[neighbor]) nonPlateNeighbors++;
 				}
 
-				int r = rand() % 9 + 1;
-				if (!hn->ocean && r < oceanNeighbors) hn->ocean = true;
-				else if (hn->ocean && r < landNeighbors) hn->ocean = false;
+				bool ocean = hexNodes.Has(i, NodeFlag::ocean);
+
+				int r = rng.Range(9) + 1;
+				if (!ocean && r < oceanNeighbors) hexNodes.Set(i, NodeFlag::ocean);
+				else if (ocean && r < landNeighbors) hexNodes.Set(i, NodeFlag::ocean, false);
 
-				if (nonPlateNeighbors != 0) hn->fault = true;
+				if (nonPlateNeighbors != 0) hexNodes.Set(i, NodeFlag::fault);
 			}
 		}
 
@@ -405,48 +369,90 @@ namespace Mandalin
 			Now that we have our oceans in place, we can
 			find all our highlands and mountains.
 		*/
-		for (int i = 0; i < hexNodes.size(); i++)
+		for (unsigned int i = 0; i < hexNodes.Size(); i++)
 		{
-			HexNode* hn = &hexNodes[i];
+			bool ocean = hexNodes.Has(i, NodeFlag::ocean);
+			bool fault = hexNodes.Has(i, NodeFlag::fault);
 
-			for (int j = 0; j < hn->neighbors.size(); j++)
+			for (unsigned int j = hexNodes.neighborOffsets[i]; j < hexNodes.neighborOffsets[i + 1]; j++)
 			{
-				HexNode* neighbor = &hexNodes[hn->neighbors[j]];
-				if (hn->ocean != neighbor->ocean) hn->oceanNeighbor = true;
-				if (!hn->fault && neighbor->fault) hn->faultNeighbor = true;
+				unsigned int neighbor = hexNodes.neighbors[j];
+				if (ocean != hexNodes.Has(neighbor, NodeFlag::ocean)) hexNodes.Set(i, NodeFlag::oceanNeighbor);
+				if (!fault && hexNodes.Has(neighbor, NodeFlag::fault)) hexNodes.Set(i, NodeFlag::faultNeighbor);
 			}
 
-			if (hn->ocean) hn->biomeVariation = 0;
-			else hn->biomeVariation = rand() % 5;
+			if (ocean) hexNodes.biomeVariation[i] = 0;
+			else hexNodes.biomeVariation[i] = rng.Range(5);
 		}
+	}
 
-		return hexNodes;
+	/*
+		The normal of one of a chunk's top triangles, pointing
+		away from the planet (the meshes aren't wound any
+		particular way).
+	*/
+	static glm::vec3 OutwardNormal(const Vertex& a, const Vertex& b, const Vertex& c)
+	{
+		glm::vec3 pa = glm::vec3(a.x, a.y, a.z);
+		glm::vec3 pb = glm::vec3(b.x, b.y, b.z);
+		glm::vec3 pc = glm::vec3(c.x, c.y, c.z);
+
+		glm::vec3 normal = glm::cross(pb - pa, pc - pa);
+		if (glm::length(normal) == 0.0f) return normal;
+		normal = glm::normalize(normal);
+
+		return (glm::dot(normal, pa + pb + pc) < 0.0f) ? -normal : normal;
 	}
 
-	void Planet::GenerateGeometry(std::vector<HexNode> hexNodes)
+	void Planet::GenerateGeometry(WorldGenContext& context)
 	{
-		srand(time(NULL));
+		HexNodes& hexNodes = context.nodes;
 
 		/*
 			Now, we go through and convert to triangles.
+
+			Each chunk gets an indexed mesh in which a hex's
+			vertices are shared by all of its triangles. The
+			indices count from the chunk's first vertex, so
+			they fit in 16 bits (a chunk holds at most 300
+			hexes of no more than 25 vertices).
+
+			A hex's triangles go around it in order, so each
+			one reuses two of the vertices of the one before
+			it, and no hex has more vertices than a vertex
+			cache holds anyway. That's about as well as the
+			cache can be used here; no two hexes share any
+			vertices, so reordering across them gains nothing.
 		*/
-		std::vector<Triangle> triangles;
+		vertices.clear();
+		indices.clear();
+		hexAttributes.clear();
 
-		for (int i = 0; i < hexNodes.size(); i++)
+		std::vector<unsigned int> chunkVertexStarts;
+		std::vector<unsigned int> chunkIndexStarts;
+
+		for (unsigned int i = 0; i < hexNodes.Size(); i++)
 		{
-			HexNode* hn = &hexNodes[i];
-			glm::vec4 color = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
-			glm::vec4 sideColor = glm::vec4(0.5f, 0.5f, 0.5f, 1.0f);
+			if (i % Settings::ChunkMaxHexes == 0)
+			{
+				chunkVertexStarts.push_back(vertices.size());
+				chunkIndexStarts.push_back(indices.size());
+			}
+
+			unsigned int chunkVertexStart = chunkVertexStarts.back();
 
-			float rise = GetRise(hn->biome);
-			glm::vec3 offset = rise * glm::normalize(hn->center);
+			glm::vec3 center = hexNodes.center[i];
+			Biome biome = hexNodes.biome[i];
+			bool hasRivers = hexNodes.Has(i, NodeFlag::rivers);
 
-			int sideBiomeVariation = (((int)hn->biome * 5) - 4);
+			float rise = GetRise(biome);
+			glm::vec3 offset = rise * glm::normalize(center);
+
+			int sideBiomeVariation = (((int)biome * 5) - 4);
 			if (sideBiomeVariation < 0) sideBiomeVariation = 0;
-			int biomeVariation = sideBiomeVariation + hn->biomeVariation;
 
 			std::vector<std::pair<unsigned int, unsigned int>> riverPartners;
-			if (hn->rivers)
+			if (hasRivers)
 			{
 				for (int j = 0; j < rivers->RiverCount(); j++)
 				{
@@ -463,33 +469,39 @@ namespace Mandalin
 
 			// Here, we find the vertices which will make up the corners
 			// of the hex.
+			unsigned int neighborCount = hexNodes.NeighborCount(i);
+
+			// Along with each corner, we keep the direction it
+			// moves in as the hex rises, so the walls know how
+			// far to drop to meet a neighbor's corner.
 			std::vector<glm::vec3> verts;
-			for (int j = 0; j < hn->neighbors.size(); j++)
+			std::vector<glm::vec3> lifts;
+			for (int j = 0; j < neighborCount; j++)
 			{
-				HexNode* neighbor1 = &hexNodes[hn->neighbors[j]];
-				HexNode* neighbor2 = &hexNodes[hn->neighbors[(j + 1) % hn->neighbors.size()]];
+				unsigned int neighbor1 = hexNodes.Neighbor(i, j);
+				unsigned int neighbor2 = hexNodes.Neighbor(i, (j + 1) % neighborCount);
 
 				bool river = false;
-				if (hn->rivers)
+				if (hasRivers)
 				{
 					for (int k = 0; k < riverPartners.size(); k++)
 					{
-						if ((riverPartners[k].first == neighbor1->index &&
-							riverPartners[k].second == neighbor2->index) ||
-							(riverPartners[k].first == neighbor2->index &&
-							riverPartners[k].second == neighbor1->index))
+						if ((riverPartners[k].first == neighbor1 &&
+							riverPartners[k].second == neighbor2) ||
+							(riverPartners[k].first == neighbor2 &&
+							riverPartners[k].second == neighbor1))
 						{
 							river = true;
 						}
 					}
 				}
 
-				glm::vec3 offset1 = rise * glm::normalize(neighbor1->center);
-				glm::vec3 offset2 = rise * glm::normalize(neighbor2->center);
+				glm::vec3 offset1 = rise * glm::normalize(hexNodes.center[neighbor1]);
+				glm::vec3 offset2 = rise * glm::normalize(hexNodes.center[neighbor2]);
 
-				glm::vec3 a = hn->center + offset;
-				glm::vec3 b = neighbor1->center + offset1;
-				glm::vec3 c = neighbor2->center + offset2;
+				glm::vec3 a = center + offset;
+				glm::vec3 b = hexNodes.center[neighbor1] + offset1;
+				glm::vec3 c = hexNodes.center[neighbor2] + offset2;
 
 				float total = 3.0f;
 				float bcMod = 1.0f;
@@ -502,240 +514,380 @@ namespace Mandalin
 
 				glm::vec3 vert = (a + b * bcMod + c * bcMod) / total;
 				verts.push_back(vert);
+
+				glm::vec3 lift = (glm::normalize(center) + glm::normalize(hexNodes.center[neighbor1]) * bcMod + glm::normalize(hexNodes.center[neighbor2]) * bcMod) / total;
+				lifts.push_back(lift);
 			}
 
 			// Quickly, we need to calculate some things.
-			float temp = (hn->temperature + 25) / 55.0f;
-			float rain = hn->rainfall / 5000.0f;
+			float temp = (hexNodes.temperature[i] + 25) / 55.0f;
+			float rain = hexNodes.rainfall[i] / 5000.0f;
+
+			// Everything but the position of a vertex lives
+			// in the hex's entry in the per-hex buffer.
+			HexAttributes attributes =
+			{
+				sideBiomeVariation,
+				(int)hexNodes.biomeVariation[i],
+				hexNodes.tectonicPlate[i],
+				(int)hasRivers,
+				temp,
+				rain,
+				0,
+				0
+			};
+
+			hexAttributes.push_back(attributes);
+
+			unsigned int topID = i;
+			unsigned int sideID = i | Vertex::SideFlag;
+
+			unsigned int n = verts.size();
 
 			// Now we go about actually putting the hex together.
-			// First, we add the top of the hex.
-			for (int j = 0; j < verts.size(); j++)
+			// First, we add the top of the hex: its center and
+			// then its corners, fanned out from the center.
+			uint16_t top = vertices.size() - chunkVertexStart;
+			glm::vec3 a = center + offset;
+
+			vertices.push_back({ a.x, a.y, a.z, topID });
+			for (int j = 0; j < n; j++) vertices.push_back({ verts[j].x, verts[j].y, verts[j].z, topID });
+
+			for (int j = 0; j < n; j++)
 			{
-				glm::vec3 a = hn->center + offset;
-				glm::vec3 b = verts[j];
-				glm::vec3 c = verts[(static_cast<unsigned long long>(j) + 1) % verts.size()];
+				indices.push_back(top);
+				indices.push_back(top + 1 + j);
+				indices.push_back(top + 1 + (j + 1) % n);
+			}
+
+			/*
+				And now we add the sides.
+
+				The side between corners j and j + 1 faces neighbor
+				j + 1, and it can only be seen if that neighbor sits
+				lower than we do. When it does, the side only has to
+				reach down to the neighbor's own top, which is where
+				the neighbor's copy of the two corners would be if
+				it had our rise.
+
+				River hexes pull their corners in along the river,
+				so they don't meet their neighbors' corners at all.
+				They keep every side, running deep into the planet,
+				to cover the gaps.
+			*/
+			glm::vec3 onset = -((radius / 4.0f) * glm::normalize(center));
 
-				Triangle t =
+			// The top corners of the sides (which need their
+			// own copies since they're colored differently from
+			// the top) are only added once a side needs them.
+			int sideCorners[8];
+			for (int j = 0; j < n; j++) sideCorners[j] = -1;
+
+			auto sideCorner = [&](unsigned int j)
+			{
+				if (sideCorners[j] < 0)
 				{
-					{ a.x, a.y, a.z, color.r, color.g, color.b, color.a, 0, biomeVariation, hn->tectonicPlate, temp, rain, 0, 0 },
-					{ b.x, b.y, b.z, color.r, color.g, color.b, color.a, 0, biomeVariation, hn->tectonicPlate, temp, rain, 0, 0 },
-					{ c.x, c.y, c.z, color.r, color.g, color.b, color.a, 0, biomeVariation, hn->tectonicPlate, temp, rain, 0, 0 }
-				};
+					sideCorners[j] = vertices.size() - chunkVertexStart;
+					vertices.push_back({ verts[j].x, verts[j].y, verts[j].z, sideID });
+				}
+
+				return (uint16_t)sideCorners[j];
+			};
+
+			for (int j = 0; j < n; j++)
+			{
+				unsigned int next = (j + 1) % n;
+				float drop = rise - GetRise(hexNodes.biome[hexNodes.Neighbor(i, next)]);
+
+				if (!hasRivers && drop <= 0.0f) continue;
+
+				glm::vec3 b = hasRivers ? verts[j] + onset : verts[j] - drop * lifts[j];
+				glm::vec3 d = hasRivers ? verts[next] + onset : verts[next] - drop * lifts[next];
+
+				uint16_t upper = sideCorner(j);
+				uint16_t nextUpper = sideCorner(next);
+				uint16_t lower = vertices.size() - chunkVertexStart;
+				uint16_t nextLower = lower + 1;
 
-				triangles.push_back(t);
-				hn->tris++;
+				vertices.push_back({ b.x, b.y, b.z, sideID });
+				vertices.push_back({ d.x, d.y, d.z, sideID });
+
+				indices.push_back(upper);
+				indices.push_back(nextLower);
+				indices.push_back(lower);
+
+				indices.push_back(upper);
+				indices.push_back(nextUpper);
+				indices.push_back(nextLower);
 			}
+		}
+
+		chunkVertexStarts.push_back(vertices.size());
+		chunkIndexStarts.push_back(indices.size());
+
+		std::cout << "Generated " << indices.size() / 3 << " triangles from " << vertices.size() << " vertices." << std::endl;
+
+		/*
+			Then the coarse meshes, which go after all the full
+			ones. Each corner is the average of the three (risen)
+			hex centers that meet there, added up in order of id
+			so that every hex sharing the corner gets exactly the
+			same point and the tops meet without any gaps.
+		*/
+		std::vector<unsigned int> coarseVertexStarts;
+		std::vector<unsigned int> coarseIndexStarts;
+
+		auto risen = [&](unsigned int hex)
+		{
+			return hexNodes.center[hex] + GetRise(hexNodes.biome[hex]) * glm::normalize(hexNodes.center[hex]);
+		};
 
-			// And now we add the sides.
-			// We only do this if necessary.
-			if (hn->oceanNeighbor || hn->biome == Biome::mountain || hn->biome == Biome::highlands || hn->rivers)
+		for (unsigned int i = 0; i < hexNodes.Size(); i++)
+		{
+			if (i % Settings::ChunkMaxHexes == 0)
 			{
-				glm::vec3 onset = -((radius / 4.0f) * glm::normalize(hn->center));
+				coarseVertexStarts.push_back(vertices.size());
+				coarseIndexStarts.push_back(indices.size());
+			}
 
-				if (hn->rivers) sideColor = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+			unsigned int n = hexNodes.NeighborCount(i);
+			uint16_t first = vertices.size() - coarseVertexStarts.back();
 
-				for (int j = 0; j < verts.size(); j++)
-				{
-					glm::vec3 a = verts[j];
-					glm::vec3 b = a + onset;
-					glm::vec3 c = verts[(static_cast<unsigned long long>(j) + 1) % verts.size()];
-					glm::vec3 d = c + onset;
+			for (unsigned int j = 0; j < n; j++)
+			{
+				unsigned int meeting[3] = { i, hexNodes.Neighbor(i, j), hexNodes.Neighbor(i, (j + 1) % n) };
+				std::sort(meeting, meeting + 3);
 
-					Triangle adb =
-					{
-						{ a.x, a.y, a.z, sideColor.r, sideColor.g, sideColor.b, sideColor.a, (int)hn->rivers, sideBiomeVariation, hn->tectonicPlate, temp, rain, 0, 0 },
-						{ d.x, d.y, d.z, sideColor.r, sideColor.g, sideColor.b, sideColor.a, (int)hn->rivers, sideBiomeVariation, hn->tectonicPlate, temp, rain, 0, 0 },
-						{ b.x, b.y, b.z, sideColor.r, sideColor.g, sideColor.b, sideColor.a, (int)hn->rivers, sideBiomeVariation, hn->tectonicPlate, temp, rain, 0, 0 }
-					};
+				glm::vec3 corner = (risen(meeting[0]) + risen(meeting[1]) + risen(meeting[2])) / 3.0f;
+				vertices.push_back({ corner.x, corner.y, corner.z, i });
+			}
 
-					Triangle acd =
-					{
-						{ a.x, a.y, a.z, sideColor.r, sideColor.g, sideColor.b, sideColor.a, (int)hn->rivers, sideBiomeVariation, hn->tectonicPlate, temp, rain, 0, 0 },
-						{ c.x, c.y, c.z, sideColor.r, sideColor.g, sideColor.b, sideColor.a, (int)hn->rivers, sideBiomeVariation, hn->tectonicPlate, temp, rain, 0, 0 },
-						{ d.x, d.y, d.z, sideColor.r, sideColor.g, sideColor.b, sideColor.a, (int)hn->rivers, sideBiomeVariation, hn->tectonicPlate, temp, rain, 0, 0 }
-					};
-
-					triangles.push_back(adb);
-					triangles.push_back(acd);
-					hn->tris += 2;
-				}
+			for (unsigned int j = 1; j + 1 < n; j++)
+			{
+				indices.push_back(first);
+				indices.push_back(first + j);
+				indices.push_back(first + j + 1);
 			}
 		}
 
+		coarseVertexStarts.push_back(vertices.size());
+		coarseIndexStarts.push_back(indices.size());
+
+		std::cout << "Generated " << (indices.size() - chunkIndexStarts.back()) / 3 << " coarse triangles." << std::endl;
+
 		/*
-			Now, we go through and convert these hex nodes to hexes.
+			For culling, the planet is stood in for by the largest
+			sphere that fits under all of the hex tops. The plane of
+			each top triangle is as close as the triangle gets to
+			the planet's center, so that's what we measure.
 		*/
-		std::cout << "Generated " << triangles.size() << " triangles." << std::endl;
+		occluderRadius = radius;
+
+		for (int i = 0; i < chunkIndexStarts.size() - 1; i++)
+		{
+			for (int k = 0; k < 2; k++)
+			{
+				unsigned int vertexStart = (k == 0) ? chunkVertexStarts[i] : coarseVertexStarts[i];
+				unsigned int indexStart = (k == 0) ? chunkIndexStarts[i] : coarseIndexStarts[i];
+				unsigned int indexEnd = (k == 0) ? chunkIndexStarts[i + 1] : coarseIndexStarts[i + 1];
+
+				for (unsigned int j = indexStart; j < indexEnd; j += 3)
+				{
+					const Vertex& a = vertices[vertexStart + indices[j]];
+					if (a.hex & Vertex::SideFlag) continue;
+
+					glm::vec3 normal = OutwardNormal(a, vertices[vertexStart + indices[j + 1]], vertices[vertexStart + indices[j + 2]]);
+					occluderRadius = std::min(occluderRadius, glm::dot(normal, glm::vec3(a.x, a.y, a.z) - position));
+				}
+			}
+		}
 
 		/*
-			Since we're going to be modifying the chunks' vbos, we need to
-			bind the vao of the renderer first.
+			How far apart neighboring hexes are on average, which
+			is what the renderer goes by to tell how big the hexes
+			of a chunk look on screen.
 		*/
+		hexSize = 0.0f;
+
+		for (unsigned int i = 0; i < hexNodes.Size(); i++)
+		{
+			hexSize += glm::distance(hexNodes.center[i], hexNodes.center[hexNodes.Neighbor(i, 0)]);
+		}
 
-		int t = 0;
-		for (int i = 0; i < hexNodes.size(); i += Settings::ChunkMaxHexes)
+		hexSize /= hexNodes.Size();
+
+		chunkBounds.Clear();
+
+		hexes.clear();
+		hexes.reserve(hexNodes.Size());
+
+		for (int i = 0; i < hexNodes.Size(); i += Settings::ChunkMaxHexes)
 		{
-			unsigned int allotedHexes = std::min(Settings::ChunkMaxHexes, (unsigned int)hexNodes.size() - i);
+			unsigned int allotedHexes = std::min(Settings::ChunkMaxHexes, hexNodes.Size() - i);
 
 			chunks.push_back({});
 			Chunk* c = &chunks[chunks.size() - 1];
 
 			c->index = chunks.size() - 1;
+			c->hexStart = i;
 			c->hexCount = allotedHexes;
-			c->triCount = 0;
+			c->full.vertexStart = chunkVertexStarts[c->index];
+			c->full.vertexCount = chunkVertexStarts[c->index + 1] - c->full.vertexStart;
+			c->full.indexStart = chunkIndexStarts[c->index];
+			c->full.indexCount = chunkIndexStarts[c->index + 1] - c->full.indexStart;
+
+			c->coarse.vertexStart = coarseVertexStarts[c->index];
+			c->coarse.vertexCount = coarseVertexStarts[c->index + 1] - c->coarse.vertexStart;
+			c->coarse.indexStart = coarseIndexStarts[c->index];
+			c->coarse.indexCount = coarseIndexStarts[c->index + 1] - c->coarse.indexStart;
 
 			c->center = glm::vec3(0.0f, 0.0f, 0.0f);
 			for (int j = i; j < i + allotedHexes; j++)
 			{
-				HexNode* hn = &hexNodes[j];
-
 				Hex hex =
 				{
 					c->index,
-					j - i,
-					hn->biome,
-					hn->biomeVariation,
-					hn->region,
-					hn->continent,
-					hn->tectonicPlate,
-					0,
+					(unsigned int)j,
+					hexNodes.biome[j],
+					hexNodes.biomeVariation[j],
+					hexNodes.region[j],
+					hexNodes.continent[j],
+					hexNodes.tectonicPlate[j],
 					0,
 					0,
 					{ 0, 0 },
 					0,
-					hn->tris,
-					c->triCount,
 					{},
+					false,
 					-1
 				};
 
 				hex.lcc = GetLandCarryingCapacity(&hex);
 
-				for (int k = 0; k < hn->neighbors.size(); k++)
-				{
-					std::pair<unsigned int, unsigned int> p =
-					{
-						hn->neighbors[k] / Settings::ChunkMaxHexes,
-						hn->neighbors[k] % Settings::ChunkMaxHexes
-					};
-
-					hex.neighbors.push_back(p);
-				}
-
-				// Add Necessary Triangles
-				c->triCount += hn->tris;
-
 				// Find Center
-				c->center += hn->center;
+				c->center += hexNodes.center[j];
 
 				// Done
-				c->hexes[j - i] = hex;
+				hexes.push_back(hex);
 			}
 
 			c->center /= allotedHexes;
 			c->center = radius * glm::normalize(c->center);
 
-			GLuint IBO;
-
-			glGenVertexArrays(1, &c->vao);
-			glBindVertexArray(c->vao);
-
-			glGenBuffers(1, &c->vbo);
-			glBindBuffer(GL_ARRAY_BUFFER, c->vbo);
-
-			glGenBuffers(1, &IBO);
-			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, IBO);
+			// And the chunk's bounds, for culling, which have to
+			// hold whichever of its meshes ends up being drawn.
+			std::vector<glm::vec3> points;
 
-			glBufferData(GL_ARRAY_BUFFER, c->triCount * sizeof(Triangle), &triangles[t], GL_DYNAMIC_DRAW);
+			for (ChunkMesh* mesh : { &c->full, &c->coarse })
+			{
+				for (unsigned int j = mesh->vertexStart; j < mesh->vertexStart + mesh->vertexCount; j++)
+				{
+					points.push_back(glm::vec3(vertices[j].x, vertices[j].y, vertices[j].z));
+				}
+			}
 
-			// Coordinates
-			glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, x));
-			glEnableVertexAttribArray(0);
+			c->bounds = BuildBoundingSphere(points);
+			chunkBounds.Add(c->bounds, BuildHorizonPoint(points, position, occluderRadius));
+		}
 
-			// Color
-			glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, r));
-			glEnableVertexAttribArray(1);
+		ocean->BuildBounds(position, occluderRadius);
 
-			// Rivers
-			glVertexAttribIPointer(2, 1, GL_INT, sizeof(Vertex), (void*)offsetof(Vertex, river));
-			glEnableVertexAttribArray(2);
+		/*
+			A node's index is its hex's id, so the planet can
+			simply keep the nodes' neighbor arrays.
+		*/
+		neighborOffsets.swap(hexNodes.neighborOffsets);
+		neighbors.swap(hexNodes.neighbors);
 
-			// Biome Color Index
-			glVertexAttribIPointer(3, 1, GL_INT, sizeof(Vertex), (void*)offsetof(Vertex, biome));
-			glEnableVertexAttribArray(3);
+		hexNodes.Clear();
+	}
 
-			// Tectonic Plate Color Index
-			glVertexAttribIPointer(4, 1, GL_INT, sizeof(Vertex), (void*)offsetof(Vertex, tectonicPlate));
-			glEnableVertexAttribArray(4);
+	void Planet::LoadGeometry()
+	{
+		if (geometryLoaded) return;
 
-			// Temperature
-			glVertexAttribPointer(5, 1, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, temperature));
-			glEnableVertexAttribArray(5);
+		/*
+			The per-hex buffer is shared by every chunk.
+		*/
+		glGenBuffers(1, &hexBuffer);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, hexBuffer);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, hexAttributes.size() * sizeof(HexAttributes), hexAttributes.data(), GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
 
-			// Rainfall
-			glVertexAttribPointer(6, 1, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, rainfall));
-			glEnableVertexAttribArray(6);
+		/*
+			So is everything else. Each chunk is drawn out of its
+			own range of these two buffers.
+		*/
+		glGenVertexArrays(1, &vao);
+		glBindVertexArray(vao);
 
-			// Population Index
-			glVertexAttribIPointer(7, 1, GL_INT, sizeof(Vertex), (void*)offsetof(Vertex, population));
-			glEnableVertexAttribArray(7);
+		glGenBuffers(1, &vbo);
+		glBindBuffer(GL_ARRAY_BUFFER, vbo);
+		glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
 
-			// Language Index
-			glVertexAttribIPointer(8, 1, GL_INT, sizeof(Vertex), (void*)offsetof(Vertex, language));
-			glEnableVertexAttribArray(8);
+		glGenBuffers(1, &ibo);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint16_t), indices.data(), GL_STATIC_DRAW);
 
-			unsigned int indices[Settings::ChunkMaxTris * 3];
-			for (int i = 0; i < Settings::ChunkMaxTris; i++)
-			{
-				const int offset = 3 * i;
+		// Coordinates
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, x));
+		glEnableVertexAttribArray(0);
 
-				indices[offset + 0] = offset + 0;
-				indices[offset + 1] = offset + 1;
-				indices[offset + 2] = offset + 2;
-			}
+		// Hex ID
+		glVertexAttribIPointer(1, 1, GL_UNSIGNED_INT, sizeof(Vertex), (void*)offsetof(Vertex, hex));
+		glEnableVertexAttribArray(1);
 
-			glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+		glBindVertexArray(0);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
-			glBindVertexArray(0);
-			glBindBuffer(GL_ARRAY_BUFFER, 0);
-			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+		vertices.clear();
+		vertices.shrink_to_fit();
+		indices.clear();
+		indices.shrink_to_fit();
 
-			t += c->triCount;
-		}
+		ocean->LoadGeometry();
 
-		glBindVertexArray(0);
-		triangles.clear();
-		hexNodes.clear();
+		geometryLoaded = true;
 
 		std::cout << "Loaded hex geometry to buffer." << std::endl;
 	}
 
-	Planet::Planet(unsigned int worldSize)
+	Planet::Planet(unsigned int worldSize, WorldSeed seed) : seed(seed)
 	{
 		this->worldSize = worldSize;
 
-		srand(time(NULL));
-
 		Polyhedron* polyhedron = new Polyhedron(worldSize);
 		this->radius = polyhedron->radius;
 
-		for (int i = 0; i < worldSize; i++) polyhedron->Subdivide();
+		grid = new HexGrid(*polyhedron, worldSize);
+
+		WorldGenContext context(seed, position, radius, Settings::WorldGenThreads);
+
+		ocean = new Ocean(*polyhedron, seed, context.workers);
+
+		for (int i = 0; i < worldSize; i++) polyhedron->Subdivide(context.workers);
 
-		ocean = new Ocean(polyhedron);
 		rivers = new RiverSystem();
 
-		std::vector<HexNode> hexNodes = Hexify(polyhedron);
-		hexNodes = SortNeighbors(hexNodes);
-		hexNodes = GenerateTopology(hexNodes);
-		hexNodes = GenerateBiomes(hexNodes, position, radius);
-		hexNodes = rivers->GenerateRivers(hexNodes);
-		GenerateGeometry(hexNodes);
+		Hexify(polyhedron, context);
+
+		// Put the nodes in their Voronoi order, then cut that
+		// up into compact chunks, which also renumbers their
+		// neighbors to match.
+		context.nodes.Permute(ChunkSort(context.nodes, VoronoiSort(context), Settings::ChunkMaxHexes));
+		grid->Index(context.nodes, context.workers);
+
+		GenerateTopology(context);
+		GenerateBiomes(context);
+		rivers->GenerateRivers(context);
+		GenerateGeometry(context);
 		delete polyhedron;
 	}
 
 	Planet::~Planet()
 	{
 		delete ocean;
+		delete grid;
 	}
 }
\ No newline at end of file
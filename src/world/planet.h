@@ -8,6 +8,9 @@
 
 #include "river.h"
 #include "../util/checkerror.h"
+#include "../util/culling.h"
+#include "../util/hexgrid.h"
+#include "../util/random.h"
 
 namespace Mandalin
 {
@@ -40,6 +43,74 @@ namespace Mandalin
 		*/
 		std::vector<Chunk>		chunks;
 
+		/*
+			The chunks' bounds have no normal cones. Every chunk
+			has sides, whose normals lie along the surface, so
+			its cone would always be too wide to cull anything;
+			the horizon is what hides the far side.
+		*/
+		CullBatch				chunkBounds = CullBatch(false);
+
+		/*
+			The radius of the largest sphere (around the
+			planet's position) which sits entirely below
+			the hexes, which is what hides the far side of
+			the planet when culling.
+		*/
+		float					occluderRadius;
+
+		// The average distance between neighboring hexes.
+		float					hexSize;
+
+		/*
+			Every hex, by id. A chunk's hexes sit next to
+			each other, starting at chunk->hexStart.
+		*/
+		std::vector<Hex>		hexes;
+
+		/*
+			The neighbors of every hex, by id. Hex i's
+			neighbors are those from neighborOffsets[i] up
+			to (but not including) neighborOffsets[i + 1].
+		*/
+		std::vector<unsigned int>	neighborOffsets;
+		std::vector<unsigned int>	neighbors;
+
+		/*
+			Coordinates for every hex that don't depend on
+			the order they're stored in (see hexgrid.h).
+		*/
+		HexGrid*				grid;
+
+		/*-----------------------------------------------*/
+		/* Geometry */
+		/*-----------------------------------------------*/
+		/*
+			The meshes of every chunk are generated on
+			the CPU and only sent to the GPU when (and if)
+			LoadGeometry is called. This way, the planet
+			and its history can be simulated without any
+			OpenGL context at all.
+		*/
+		std::vector<Vertex>		vertices;
+		std::vector<uint16_t>	indices;
+		bool					geometryLoaded = false;
+
+		// Every chunk's geometry, once it's on the GPU.
+		GLuint					vao = 0;
+		GLuint					vbo = 0;
+		GLuint					ibo = 0;
+
+		/*
+			Each hex has a single entry in the per-hex
+			buffer (indexed by its id) which its vertices
+			look themselves up in.
+		*/
+		std::vector<HexAttributes>	hexAttributes;
+		GLuint					hexBuffer = 0;
+
+		void					MarkDirty(Hex* h);
+
 		/*-----------------------------------------------*/
 		/* Ocean */
 		/*-----------------------------------------------*/
@@ -55,6 +126,13 @@ namespace Mandalin
 		/*-----------------------------------------------*/
 		unsigned int			worldSize;
 
+		/*
+			Every random number drawn while generating the
+			world comes out of a stream of this seed, so the
+			same seed and world size give the same planet.
+		*/
+		WorldSeed				seed;
+
 	public:
 		/*-----------------------------------------------*/
 		/* Variable Functions */
@@ -62,6 +140,7 @@ namespace Mandalin
 		glm::vec3				GetPosition() { return position; }
 		float					GetRadius() { return radius; }
 		unsigned int			GetWorldSize() { return worldSize; }
+		WorldSeed				GetSeed() { return seed; }
 		unsigned int			GetTotalTriangles() { return totalTriangles; }
 
 		/*-----------------------------------------------*/
@@ -69,11 +148,35 @@ namespace Mandalin
 		/*-----------------------------------------------*/
 		unsigned int			ChunkCount() { return chunks.size(); }
 		Chunk*					GetChunk(unsigned int i) { return &chunks[i]; }
+		const CullBatch&		GetChunkBounds() { return chunkBounds; }
+		float					GetOccluderRadius() { return occluderRadius; }
+		float					GetHexSize() { return hexSize; }
+
+		/*-----------------------------------------------*/
+		/* Hexes */
+		/*-----------------------------------------------*/
+		unsigned int			HexCount() { return hexes.size(); }
+		Hex*					GetHex(unsigned int id) { return &hexes[id]; }
+		Chunk*					GetHexChunk(Hex* hex) { return &chunks[hex->chunk]; }
 
-		Hex*					GetHex(unsigned int chunk, unsigned int index);
+		unsigned int			NeighborCount(Hex* hex) { return neighborOffsets[hex->id + 1] - neighborOffsets[hex->id]; }
+		Hex*					GetNeighbor(Hex* hex, unsigned int i) { return &hexes[neighbors[neighborOffsets[hex->id] + i]]; }
 
-		void					SetPopulation(unsigned int chunk, unsigned int hex, int population);
-		void					SetLanguage(unsigned int chunk, unsigned int hex, int language);
+		HexGrid*				GetGrid() { return grid; }
+		Hex*					GetHex(HexCoord coord);
+		Hex*					LocateHex(glm::vec3 point);
+
+		void					SetPopulation(unsigned int hex, int population);
+		void					SetLanguage(unsigned int hex, int language);
+
+		/*-----------------------------------------------*/
+		/* Geometry, Cont. */
+		/*-----------------------------------------------*/
+		bool					GeometryLoaded() { return geometryLoaded; }
+		GLuint					GetVAO() { return vao; }
+		GLuint					GetHexBuffer() { return hexBuffer; }
+		void					LoadGeometry();
+		void					FlushChunks();
 
 		/*-----------------------------------------------*/
 		/* Ocean */
@@ -93,16 +196,14 @@ namespace Mandalin
 			wind, currents, biomes, etc.)
 		*/
 		float					GetRise(Biome biome);
-		Biome					GetBiome(HexNode* hn);
-		std::vector<HexNode>	Hexify(Polyhedron* polyhedron);
-		std::vector<HexNode>	SortNeighbors(std::vector<HexNode> hexNodes);
-		std::vector<HexNode>	GenerateTopology(std::vector<HexNode> hexNodes);
-		void					GenerateGeometry(std::vector<HexNode> hexNodes);
+		void					Hexify(Polyhedron* polyhedron, WorldGenContext& context);
+		void					GenerateTopology(WorldGenContext& context);
+		void					GenerateGeometry(WorldGenContext& context);
 
 		/*---------------------*/
 		/* Constructor         */
 		/*---------------------*/
-		Planet(unsigned int worldSize);
+		Planet(unsigned int worldSize, WorldSeed seed);
 		~Planet();
 	};
 }
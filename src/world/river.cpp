@@ -2,8 +2,10 @@
 
 namespace Mandalin
 {
-	std::vector<HexNode> RiverSystem::GenerateRivers(std::vector<HexNode> hexNodes)
+	void RiverSystem::GenerateRivers(WorldGenContext& context)
 	{
+		HexNodes& hexNodes = context.nodes;
+
 		/*
 			First, we're going to generate a gradient across all the tiles
 			which will allow us to simplify the river-flowing process.
@@ -13,14 +15,12 @@ namespace Mandalin
 			down progressively away from mountains.
 		*/
 		std::vector<unsigned int> checked;
-		for (int i = 0; i < hexNodes.size(); i++)
+		for (unsigned int i = 0; i < hexNodes.Size(); i++)
 		{
-			HexNode* hn = &hexNodes[i];
-
-			if (hn->biome == Biome::mountain)
+			if (hexNodes.biome[i] == Biome::mountain)
 			{
 				checked.push_back(i);
-				hn->mountainDistance = 0;
+				hexNodes.mountainDistance[i] = 0;
 			}
 		}
 
@@ -30,23 +30,22 @@ namespace Mandalin
 			
 			for (int i = 0; i < checked.size(); i++)
 			{
-				HexNode* hn = &hexNodes[checked[i]];
+				unsigned int hn = checked[i];
 
-				for (int j = 0; j < hn->neighbors.size(); j++)
+				for (unsigned int j = hexNodes.neighborOffsets[hn]; j < hexNodes.neighborOffsets[hn + 1]; j++)
 				{
-					HexNode* neigh = &hexNodes[hn->neighbors[j]];
+					unsigned int neigh = hexNodes.neighbors[j];
 
-					if (neigh->mountainDistance == -1)
+					if (hexNodes.mountainDistance[neigh] == -1)
 					{
-						neigh->mountainDistance = hn->mountainDistance + 1;
-						newAdditions.push_back(hn->neighbors[j]);
+						hexNodes.mountainDistance[neigh] = hexNodes.mountainDistance[hn] + 1;
+						newAdditions.push_back(neigh);
 					}
 				}
 			}
 
 			if (newAdditions.size() == 0) break;
-			checked.clear();
-			for (int i = 0; i < newAdditions.size(); i++) checked.push_back(newAdditions[i]);
+			checked.swap(newAdditions);
 		}
 
 		for (int riverID = 0; riverID < Settings::RiverCount; riverID++)
@@ -70,7 +69,5 @@ namespace Mandalin
 
 			rivers.push_back(river);
 		}
-
-		return hexNodes;
 	}
 }
\ No newline at end of file
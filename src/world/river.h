@@ -36,7 +36,7 @@ namespace Mandalin
 		unsigned int			RiverCount() { return rivers.size(); }
 		River*					GetRiver(unsigned int i) { return &rivers[i]; }
 
-		std::vector<HexNode>	GenerateRivers(std::vector<HexNode> hexNodes);
+		void					GenerateRivers(WorldGenContext& context);
 	};
 
 }